@@ -20,11 +20,13 @@
 #include "Weaver.h"
 #include <log/log.h>
 #include <string.h>
+#include <algorithm>
+#include <future>
+#include <cutils/android_filesystem_config.h>
 #include <hidl/LegacySupport.h>
-#include <weaver_interface.h>
-#include <weaver-impl.h>
-
-/* Mutex to synchronize multiple transceive */
+#include <hwbinder/IPCThreadState.h>
+#include <weaver_async_interface.h>
+#include <weaver-async-impl.h>
 
 namespace android {
 namespace hardware {
@@ -32,10 +34,11 @@ namespace weaver {
 namespace V1_0 {
 namespace implementation {
 
-  WeaverInterface *pInterface = nullptr;
+  WeaverAsyncInterface *pInterface = nullptr;
+
   Weaver::Weaver() {
     ALOGI("INITILIZING WEAVER");
-    pInterface = WeaverImpl::getInstance();
+    pInterface = WeaverAsyncImpl::getInstance();
     if(pInterface != NULL) {
       pInterface->Init();
     }
@@ -52,8 +55,17 @@ namespace implementation {
       _hidl_cb(WeaverStatus::FAILED, configResp);
       return Void();
     }
-    SlotInfo slotInfo;
-    Status_Weaver status = pInterface->GetSlots(slotInfo);
+    auto result = std::make_shared<std::promise<std::pair<Status_Weaver, SlotInfo>>>();
+    std::future<std::pair<Status_Weaver, SlotInfo>> future = result->get_future();
+    uint64_t requestId = pInterface->GetSlotsAsync(
+        [result](Status_Weaver status, const SlotInfo& slotInfo) {
+          result->set_value({status, slotInfo});
+        });
+    if (!pInterface->WaitForCompletion(future, requestId)) {
+      _hidl_cb(WeaverStatus::FAILED, configResp);
+      return Void();
+    }
+    auto [status, slotInfo] = future.get();
     if(status == WEAVER_STATUS_OK) {
       configResp.slots =  slotInfo.slots;
       configResp.keySize = slotInfo.keySize;
@@ -70,8 +82,19 @@ namespace implementation {
     Weaver::write(uint32_t slotId, const hidl_vec<uint8_t>& key, const hidl_vec<uint8_t>& value) {
       ALOGI("Write API ENTRY");
       WeaverStatus status = WeaverStatus::FAILED;
-      if(key != NULL && value != NULL && pInterface != NULL
-          && (pInterface->Write(slotId, key, value) == WEAVER_STATUS_OK)) {
+      if(key == NULL || value == NULL || pInterface == NULL) {
+        return status;
+      }
+      auto result = std::make_shared<std::promise<Status_Weaver>>();
+      std::future<Status_Weaver> future = result->get_future();
+      /* backend copies key & value straight from the parcel into its pool */
+      uint64_t requestId = pInterface->WriteAsync(slotId,
+          std::span<const uint8_t>(key.data(), key.size()),
+          std::span<const uint8_t>(value.data(), value.size()),
+          [result](Status_Weaver writeStatus) { result->set_value(writeStatus); });
+      /* a write reaching the SE must not be reported failed */
+      if (pInterface->WaitForCompletion(future, requestId, true /*waitIfStarted*/) &&
+          future.get() == WEAVER_STATUS_OK) {
         status = WeaverStatus::OK;
       }
       return status;
@@ -84,13 +107,27 @@ namespace implementation {
       if(key == NULL || _hidl_cb == NULL || pInterface == NULL) {
         _hidl_cb(WeaverReadStatus::FAILED, readResp);
       } else {
-        ReadRespInfo readInfo;
-        Status_Weaver status = pInterface->Read(slotId, key, readInfo);
+        auto result =
+            std::make_shared<std::promise<std::pair<Status_Weaver, ReadRespInfo>>>();
+        std::future<std::pair<Status_Weaver, ReadRespInfo>> future = result->get_future();
+        uint64_t requestId = pInterface->ReadAsync(slotId,
+            std::span<const uint8_t>(key.data(), key.size()),
+            [result](Status_Weaver status, const ReadRespInfo& readInfo) {
+              result->set_value({status, readInfo});
+            });
+        Status_Weaver status = WEAVER_STATUS_FAILED;
+        ReadRespInfo readInfo = {};
+        if (pInterface->WaitForCompletion(future, requestId)) {
+          std::tie(status, readInfo) = future.get();
+        }
         switch (status) {
           case WEAVER_STATUS_OK:
             ALOGI("Read OK");
-            readResp.value = readInfo.value;
+            readResp.value = hidl_vec<uint8_t>(readInfo.value.begin(),
+                                               readInfo.value.end());
             _hidl_cb(WeaverReadStatus::OK, readResp);
+            /* value is parceled by now, don't leave it on the heap */
+            std::fill(readResp.value.begin(), readResp.value.end(), 0);
             break;
           case WEAVER_STATUS_INCORRECT_KEY:
             ALOGI("Read Incorrect Key");
@@ -113,9 +150,42 @@ namespace implementation {
       return Void();
     }
 
+  /* Pre-opens the applet channel ahead of an imminent read */
+  Return<void> Weaver::credentialEntryImminent(uint32_t windowMs) {
+    uid_t uid = ::android::hardware::IPCThreadState::self()->getCallingUid();
+    if (uid != AID_SYSTEM) {
+      ALOGE("Warm up hint from untrusted uid (%u) ignored", uid);
+      return Void();
+    }
+    if(pInterface != NULL) {
+      pInterface->PrepareAsync(windowMs, [](Status_Weaver status) {
+        if (status != WEAVER_STATUS_OK) {
+          ALOGE("Warm up hint failed (%d)", status);
+        }
+      });
+    }
+    return Void();
+  }
+
+  /* Dumps SE access queue wait statistics, e.g. "lshal debug" */
+  Return<void> Weaver::debug(const hidl_handle& handle,
+                             const hidl_vec<hidl_string>& /*options*/) {
+    if (handle.getNativeHandle() == nullptr || handle->numFds < 1) {
+      ALOGE("Invalid debug handle");
+      return Void();
+    }
+    int fd = handle->data[0];
+    if(pInterface != NULL) {
+      pInterface->Dump(fd);
+    }
+    return Void();
+  }
+
   void Weaver::serviceDied(uint64_t /*cookie*/, const wp<IBase>& /*who*/) {
     if(pInterface != NULL) {
       pInterface->DeInit();
+      /* DeInit refuses requests until re-initialized, serve other clients */
+      pInterface->Init();
     }
   }
 }
@@ -20,6 +20,7 @@
 
 #include <android/hardware/weaver/1.0/IWeaver.h>
 #include <android/hardware/weaver/1.0/types.h>
+#include <vendor/thales/hardware/weaver/1.0/IWeaverExtension.h>
 #include <hardware/hardware.h>
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
@@ -32,8 +33,10 @@ namespace V1_0 {
 namespace implementation {
 
 using android::hardware::weaver::V1_0::IWeaver;
+using vendor::thales::hardware::weaver::V1_0::IWeaverExtension;
 using ::android::hidl::base::V1_0::IBase;
 using ::android::hardware::hidl_array;
+using ::android::hardware::hidl_handle;
 using ::android::hardware::hidl_memory;
 using ::android::hardware::hidl_string;
 using ::android::hardware::hidl_vec;
@@ -42,7 +45,7 @@ using ::android::hardware::Void;
 using ::android::sp;
 using android::base::StringPrintf;
 
-struct Weaver : public IWeaver, public hidl_death_recipient {
+struct Weaver : public IWeaverExtension, public hidl_death_recipient {
   Weaver();
   Return<void>
     getConfig(getConfig_cb _hidl_cb) override;
@@ -52,6 +55,11 @@ struct Weaver : public IWeaver, public hidl_death_recipient {
   Return<void>
   read(uint32_t slotId, const hidl_vec<uint8_t>& key, read_cb _hidl_cb) override;
 
+  Return<void> credentialEntryImminent(uint32_t windowMs) override;
+
+  Return<void>
+  debug(const hidl_handle& handle, const hidl_vec<hidl_string>& options) override;
+
   void serviceDied(uint64_t /*cookie*/, const wp<IBase>& /*who*/);
 };
 
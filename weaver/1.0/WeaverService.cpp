@@ -19,13 +19,25 @@
 #include <log/log.h>
 #include <android/hardware/weaver/1.0/IWeaver.h>
 #include <android/hardware/weaver/1.0/types.h>
+#include <vendor/thales/hardware/weaver/1.0/IWeaverExtension.h>
 
+#include <android/binder_process.h>
 #include <hidl/LegacySupport.h>
 #include <string.h>
 #include "Weaver.h"
+#ifdef WEAVER_LAZY_HAL
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <cutils/properties.h>
+#include <hidl/HidlLazyUtils.h>
+#include <weaver-async-impl.h>
+#endif
 
 // Generated HIDL files
 using android::hardware::weaver::V1_0::IWeaver;
+using vendor::thales::hardware::weaver::V1_0::IWeaverExtension;
 using android::hardware::weaver::V1_0::implementation::Weaver;
 using android::hardware::defaultPassthroughServiceImplementation;
 using android::OK;
@@ -37,19 +49,98 @@ using android::sp;
 using android::status_t;
 using android::OK;
 
+/* Number of binder threads serving Weaver requests concurrently */
+#define WEAVER_RPC_THREADS 4
+
+#ifdef WEAVER_LAZY_HAL
+using android::hardware::LazyServiceRegistrar;
+
+/* Time without clients before the lazy service exits, overridable by prop */
+#define WEAVER_LAZY_IDLE_PROP "ro.vendor.weaver.lazy_idle_ms"
+#define WEAVER_LAZY_IDLE_TIMEOUT (30 * 1000) // 30 secs
+/* Time the SE connection is kept prepared for the request that started us */
+#define WEAVER_LAZY_WARMUP_WINDOW (5 * 1000) // 5 secs
+
+static std::mutex sIdleLock;
+static std::condition_variable sIdleCond;
+static bool sHasClients = true;
+
+/* Client count change of the registered services, see LazyServiceRegistrar */
+static bool onActiveServices(bool hasClients) {
+  {
+    std::lock_guard<std::mutex> lock(sIdleLock);
+    sHasClients = hasClients;
+  }
+  sIdleCond.notify_all();
+  /* exit is deferred to idleExitThread so that the idle period applies */
+  return true;
+}
+
+/* Exits the process once it has been without clients for idleMs */
+static void idleExitThread(int32_t idleMs) {
+  LazyServiceRegistrar &registrar = LazyServiceRegistrar::getInstance();
+  std::unique_lock<std::mutex> lock(sIdleLock);
+  for (;;) {
+    sIdleCond.wait(lock, [] { return !sHasClients; });
+    if (sIdleCond.wait_for(lock, std::chrono::milliseconds(idleMs),
+                           [] { return sHasClients; })) {
+      continue;
+    }
+    lock.unlock();
+    /* fails if a client came back in the meantime */
+    if (registrar.tryUnregister()) {
+      ALOGI("Weaver Service idle for %d ms, exiting", idleMs);
+      WeaverAsyncImpl::getInstance()->DeInit();
+      exit(EXIT_SUCCESS);
+    }
+    registrar.reRegister();
+    lock.lock();
+  }
+}
+
+/* Registers as lazy service, the process is started on demand by init */
+static status_t registerLazyService(const android::sp<IWeaverExtension> &service) {
+  LazyServiceRegistrar &registrar = LazyServiceRegistrar::getInstance();
+  status_t status = registrar.registerService(service);
+  if (status != OK) {
+    return status;
+  }
+  int32_t idleMs = property_get_int32(WEAVER_LAZY_IDLE_PROP, WEAVER_LAZY_IDLE_TIMEOUT);
+  ALOGI("Weaver Service is lazy, idle timeout %d ms", idleMs);
+  registrar.setActiveServicesCallback(onActiveServices);
+  std::thread(idleExitThread, idleMs).detach();
+  /* A client is waiting for us, connect to SE while it issues its request */
+  WeaverAsyncImpl::getInstance()->PrepareAsync(WEAVER_LAZY_WARMUP_WINDOW,
+      [](Status_Weaver status) {
+        if (status != WEAVER_STATUS_OK) {
+          ALOGE("Warm up after start failed (%d)", status);
+        }
+      });
+  return OK;
+}
+#endif
+
 int main() {
   try {
     status_t status;
 
-    android::sp<IWeaver> weaver_service = nullptr;
+    /* Registering the extension also registers it as IWeaver */
+    android::sp<IWeaverExtension> weaver_service = nullptr;
     ALOGI("Weaver HAL Service 1.0 is starting.");
     weaver_service = new Weaver();
     if (weaver_service == nullptr) {
       ALOGE("Can not create an instance of Weaver HAL Interface, exiting.");
       goto shutdown;
     }
-    configureRpcThreadpool(1, true /*callerWillJoin*/);
+    configureRpcThreadpool(WEAVER_RPC_THREADS, true /*callerWillJoin*/);
+    /* /dev/binder threads deliver death notifications & callbacks of the
+     * AIDL services the transport talks to */
+    ABinderProcess_startThreadPool();
+#ifdef WEAVER_LAZY_HAL
+    status = registerLazyService(weaver_service);
+#else
     status = weaver_service->registerAsService();
+#endif
 
     if (status != OK) {
       ALOGE("Could not register service for Weaver HAL Interface (%d)", status);
@@ -0,0 +1,152 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+#define LOG_TAG "Weaver-service"
+
+#include "Weaver.h"
+#include <log/log.h>
+#include <future>
+#include <weaver_async_interface.h>
+#include <weaver-async-impl.h>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace weaver {
+
+static WeaverAsyncInterface *pInterface = nullptr;
+
+static ::ndk::ScopedAStatus failed() {
+  return ::ndk::ScopedAStatus::fromServiceSpecificError(IWeaver::STATUS_FAILED);
+}
+
+Weaver::Weaver() {
+  ALOGI("INITILIZING WEAVER");
+  pInterface = WeaverAsyncImpl::getInstance();
+  if (pInterface != NULL) {
+    pInterface->Init();
+  }
+}
+
+::ndk::ScopedAStatus Weaver::getConfig(WeaverConfig *_aidl_return) {
+  ALOGI("GETCONFIG API ENTRY");
+  if (pInterface == NULL) {
+    ALOGI("Weaver Interface not defined");
+    return failed();
+  }
+  auto result =
+      std::make_shared<std::promise<std::pair<Status_Weaver, SlotInfo>>>();
+  std::future<std::pair<Status_Weaver, SlotInfo>> future = result->get_future();
+  uint64_t requestId = pInterface->GetSlotsAsync(
+      [result](Status_Weaver status, const SlotInfo &slotInfo) {
+        result->set_value({status, slotInfo});
+      });
+  if (!pInterface->WaitForCompletion(future, requestId)) {
+    return failed();
+  }
+  auto [status, slotInfo] = future.get();
+  if (status != WEAVER_STATUS_OK) {
+    return failed();
+  }
+  _aidl_return->slots = slotInfo.slots;
+  _aidl_return->keySize = slotInfo.keySize;
+  _aidl_return->valueSize = slotInfo.valueSize;
+  ALOGI("Weaver Success for getSlots Slots :(%d)", _aidl_return->slots);
+  return ::ndk::ScopedAStatus::ok();
+}
+
+::ndk::ScopedAStatus Weaver::read(int32_t in_slotId,
+                                  const std::vector<uint8_t> &in_key,
+                                  WeaverReadResponse *_aidl_return) {
+  ALOGI("Read API ENTRY");
+  _aidl_return->timeout = 0;
+  _aidl_return->value.clear();
+  _aidl_return->status = WeaverReadStatus::FAILED;
+  if (pInterface == NULL || in_slotId < 0) {
+    return ::ndk::ScopedAStatus::ok();
+  }
+  auto result =
+      std::make_shared<std::promise<std::pair<Status_Weaver, ReadRespInfo>>>();
+  std::future<std::pair<Status_Weaver, ReadRespInfo>> future =
+      result->get_future();
+  /* backend copies key straight from the parcel into its pool */
+  uint64_t requestId = pInterface->ReadAsync(
+      in_slotId, in_key,
+      [result](Status_Weaver status, const ReadRespInfo &readInfo) {
+        result->set_value({status, readInfo});
+      });
+  if (!pInterface->WaitForCompletion(future, requestId)) {
+    return ::ndk::ScopedAStatus::ok();
+  }
+  auto [status, readInfo] = future.get();
+  switch (status) {
+  case WEAVER_STATUS_OK:
+    ALOGI("Read OK");
+    _aidl_return->value.assign(readInfo.value.begin(), readInfo.value.end());
+    _aidl_return->status = WeaverReadStatus::OK;
+    break;
+  case WEAVER_STATUS_INCORRECT_KEY:
+    ALOGI("Read Incorrect Key");
+    _aidl_return->timeout = readInfo.timeout;
+    _aidl_return->status = WeaverReadStatus::INCORRECT_KEY;
+    break;
+  case WEAVER_STATUS_THROTTLE:
+    ALOGI("Read WEAVER_THROTTLE");
+    _aidl_return->timeout = readInfo.timeout;
+    _aidl_return->status = WeaverReadStatus::THROTTLE;
+    break;
+  default:
+    break;
+  }
+  return ::ndk::ScopedAStatus::ok();
+}
+
+::ndk::ScopedAStatus Weaver::write(int32_t in_slotId,
+                                   const std::vector<uint8_t> &in_key,
+                                   const std::vector<uint8_t> &in_value) {
+  ALOGI("Write API ENTRY");
+  if (pInterface == NULL || in_slotId < 0) {
+    return failed();
+  }
+  auto result = std::make_shared<std::promise<Status_Weaver>>();
+  std::future<Status_Weaver> future = result->get_future();
+  /* backend copies key & value straight from the parcel into its pool */
+  uint64_t requestId = pInterface->WriteAsync(
+      in_slotId, in_key, in_value,
+      [result](Status_Weaver writeStatus) { result->set_value(writeStatus); });
+  /* a write reaching the SE must not be reported failed */
+  if (pInterface->WaitForCompletion(future, requestId,
+                                    true /*waitIfStarted*/) &&
+      future.get() == WEAVER_STATUS_OK) {
+    return ::ndk::ScopedAStatus::ok();
+  }
+  return failed();
+}
+
+/* Dumps SE access queue wait statistics, e.g. "dumpsys" */
+binder_status_t Weaver::dump(int fd, const char ** /*args*/,
+                             uint32_t /*numArgs*/) {
+  if (pInterface != NULL) {
+    pInterface->Dump(fd);
+  }
+  return STATUS_OK;
+}
+
+} // namespace weaver
+} // namespace hardware
+} // namespace android
+} // namespace aidl
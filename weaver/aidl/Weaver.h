@@ -0,0 +1,47 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+#ifndef AIDL_ANDROID_HARDWARE_WEAVER_WEAVER_H
+#define AIDL_ANDROID_HARDWARE_WEAVER_WEAVER_H
+
+#include <aidl/android/hardware/weaver/BnWeaver.h>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace weaver {
+
+/* Binder NDK front end of the weaver backend, see 1.0 for HIDL */
+class Weaver : public BnWeaver {
+public:
+  Weaver();
+  ::ndk::ScopedAStatus getConfig(WeaverConfig *_aidl_return) override;
+  ::ndk::ScopedAStatus read(int32_t in_slotId,
+                            const std::vector<uint8_t> &in_key,
+                            WeaverReadResponse *_aidl_return) override;
+  ::ndk::ScopedAStatus write(int32_t in_slotId,
+                             const std::vector<uint8_t> &in_key,
+                             const std::vector<uint8_t> &in_value) override;
+  binder_status_t dump(int fd, const char **args, uint32_t numArgs) override;
+};
+
+} // namespace weaver
+} // namespace hardware
+} // namespace android
+} // namespace aidl
+
+#endif // AIDL_ANDROID_HARDWARE_WEAVER_WEAVER_H
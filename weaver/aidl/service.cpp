@@ -0,0 +1,48 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+#define LOG_TAG "Weaver-service"
+#include <log/log.h>
+#include <android/binder_manager.h>
+#include <android/binder_process.h>
+#include <string>
+#include "Weaver.h"
+
+using aidl::android::hardware::weaver::Weaver;
+
+/* Number of binder threads serving Weaver requests concurrently */
+#define WEAVER_RPC_THREADS 4
+
+int main() {
+  ALOGI("Weaver AIDL HAL Service is starting.");
+  ABinderProcess_setThreadPoolMaxThreadCount(WEAVER_RPC_THREADS);
+  std::shared_ptr<Weaver> weaver = ndk::SharedRefBase::make<Weaver>();
+  const std::string instance = std::string(Weaver::descriptor) + "/default";
+  binder_status_t status =
+      AServiceManager_addService(weaver->asBinder().get(), instance.c_str());
+  if (status != STATUS_OK) {
+    ALOGE("Could not register service for Weaver HAL Interface (%d)", status);
+    return 1;
+  }
+  ALOGI("Weaver Service is ready");
+  /* spawn the pool threads, join alone serves on the main thread only */
+  ABinderProcess_startThreadPool();
+  ABinderProcess_joinThreadPool();
+  // In normal operation, we don't expect the thread pool to exit
+  ALOGE("Weaver Service is shutting down");
+  return 1;
+}
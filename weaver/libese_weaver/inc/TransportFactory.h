@@ -37,25 +37,33 @@
 #ifndef __SE_TRANSPORT_FACTORY__
 #define __SE_TRANSPORT_FACTORY__
 
+#include "AidlSeTransport.h"
 #include "HalToHalTransport.h"
 #include "OmapiTransport.h"
 
 namespace se_transport {
 
+using keymint::javacard::AdaptiveSessionTimeoutPolicy;
+using keymint::javacard::AidlSeTransport;
 using keymint::javacard::HalToHalTransport;
 using keymint::javacard::ITransport;
+using keymint::javacard::SessionTimeoutPolicy;
+using keymint::javacard::TRANSPORT_EVENT_CB;
 #ifdef OMAPI_TRANSPORT
 using keymint::javacard::OmapiTransport;
 #endif
 
 /**
  * TransportFactory class decides which transport mechanism to be used to send data to secure element.
- * The communication channel is via OMAPI.
+ * The communication channel is via OMAPI, or with AIDL_SE_TRANSPORT directly via the AIDL secure
+ * element HAL.
  */
 class TransportFactory {
     public:
     TransportFactory(const std::vector<uint8_t>& mAppletAID) {
-#ifdef OMAPI_TRANSPORT
+#if defined AIDL_SE_TRANSPORT
+            mTransport = std::unique_ptr<AidlSeTransport>(new AidlSeTransport(mAppletAID));
+#elif defined OMAPI_TRANSPORT
             mTransport = std::unique_ptr<OmapiTransport>(new OmapiTransport(mAppletAID));
 #else
             mTransport = std::unique_ptr<HalToHalTransport>(new HalToHalTransport(mAppletAID));
@@ -72,12 +80,26 @@ class TransportFactory {
     }
 
     /**
-     * Sends the data to the secure element and also receives back the data.
+     * Sends the data to the secure element and also receives back the data into the caller
+     * owned output buffer, output is narrowed to the response length.
      * This is a blocking call.
      */
-    inline bool sendData(const uint8_t* inData, const size_t inLen, std::vector<uint8_t>& output) {
-        std::vector input(inData, inData + inLen);
-        return mTransport->sendData(input, output);
+    inline bool sendData(std::span<const uint8_t> inData, std::span<uint8_t>& output) {
+        return mTransport->sendData(inData, output);
+    }
+
+    /**
+     * Close the logical channel, the session is kept.
+     */
+    inline bool closeChannel() {
+        return mTransport->closeChannel();
+    }
+
+    /**
+     * Close the logical channel and the session, the connection is kept.
+     */
+    inline bool closeSession() {
+        return mTransport->closeSession();
     }
 
     /**
@@ -94,6 +116,34 @@ class TransportFactory {
         return mTransport->isConnected();
     }
 
+    /**
+     * Provides the SELECT response of the last opened logical channel.
+     */
+    inline bool getSelectResponse(std::vector<uint8_t>& resp) {
+        return mTransport->getSelectResponse(resp);
+    }
+
+    /**
+     * Registers the callback to be notified of transport events.
+     */
+    inline void setEventCallback(void* ctx, TRANSPORT_EVENT_CB cb) {
+        mTransport->setEventCallback(ctx, cb);
+    }
+
+    /**
+     * Replaces the policy deciding the idle timeout of the logical channel.
+     */
+    inline void setSessionTimeoutPolicy(std::shared_ptr<SessionTimeoutPolicy> policy) {
+        mTransport->setSessionTimeoutPolicy(policy);
+    }
+
+    /**
+     * Sets the lower bound of the regular idle timeout of the logical channel.
+     */
+    inline void setMinSessionTimeout(int minTimeout) {
+        mTransport->setMinSessionTimeout(minTimeout);
+    }
+
     private:
     /**
      * Holds the instance of OmapiTransport class
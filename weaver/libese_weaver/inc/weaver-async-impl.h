@@ -0,0 +1,181 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef _WEAVER_ASYNC_IMPL_H_
+#define _WEAVER_ASYNC_IMPL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <weaver_async_interface.h>
+#include <weaver_interface.h>
+
+/* Number of worker threads executing requests. Secure element access is
+ * serialized by WeaverImpl, other work (e.g. cached getConfig) runs parallel */
+#define WEAVER_ASYNC_WORKERS 4
+
+class WeaverAsyncImpl : public WeaverAsyncInterface {
+public:
+  /**
+   * \brief Function to initilize Weaver Async Interface
+   *
+   * \retval This function return Weaver_STATUS_OK (0) in case of success
+   *         In case of failure returns other Status_Weaver.
+   */
+  Status_Weaver Init() override;
+
+  /**
+   * \brief Function to submit read of slot information
+   * \param[in]    cb -           callback invoked with slot information
+   *
+   * \retval This function return id of the submitted request
+   */
+  uint64_t GetSlotsAsync(GetSlotsCallback cb) override;
+
+  /**
+   * \brief Function to submit read of specific key & slotId
+   * \param[in]    slotId -       input slotId which's information to be read
+   * \param[in]    key -          input key which's information to be read
+   * \param[in]    cb -           callback invoked with read information
+   *
+   * \retval This function return id of the submitted request
+   */
+  uint64_t ReadAsync(uint32_t slotId, std::span<const uint8_t> key,
+                     ReadCallback cb) override;
+
+  /**
+   * \brief Function to submit write of value to specific key & slotId
+   * \param[in]    slotId -       input slotId where value to be write
+   * \param[in]    key -          input key where value to be write
+   * \param[in]    value -        input value which will be written
+   * \param[in]    cb -           callback invoked with write status
+   *
+   * \retval This function return id of the submitted request
+   */
+  uint64_t WriteAsync(uint32_t slotId, std::span<const uint8_t> key,
+                      std::span<const uint8_t> value,
+                      WriteCallback cb) override;
+
+  /**
+   * \brief Function to submit multiple read/write operations to be performed
+   *        in one session
+   * \param[in]    ops -          operations to be performed, in order
+   * \param[in]    cb -           callback invoked with result of operations
+   *
+   * \retval This function return id of the submitted request
+   */
+  uint64_t BatchAsync(const std::vector<WeaverOperation> &ops,
+                      BatchCallback cb) override;
+
+  /**
+   * \brief Function to submit connection & applet selection ahead of an
+   * imminent read
+   * \param[in]    windowMs -     period in ms to keep the channel open
+   * \param[in]    cb -           callback invoked with status
+   *
+   * \retval This function return id of the submitted request
+   */
+  uint64_t PrepareAsync(uint32_t windowMs, PrepareCallback cb) override;
+
+  /**
+   * \brief Function to cancel a submitted request
+   * \param[in]    requestId -    id of the request to be cancelled
+   *
+   * \retval This function return true if request was still pending and is
+   *         dropped without invoking its callback, false if it has already
+   *         been started or completed.
+   */
+  bool Cancel(uint64_t requestId) override;
+
+  /**
+   * \brief Function to de-initilize Weaver Async Interface. New requests are
+   * refused and pending ones completed as failed until next Init, started
+   * ones are waited for before the transport is closed
+   *
+   * \retval This function return Weaver_STATUS_OK (0) in case of success
+   *         In case of failure returns other Status_Weaver.
+   */
+  Status_Weaver DeInit() override;
+
+  /**
+   * \brief Function to dump state & statistics of Weaver Async Interface
+   * \param[in]    fd -           file descriptor to write to
+   */
+  void Dump(int fd) override;
+
+  /**
+   * \brief static function to get the singleton instance of WeaverAsyncImpl
+   * class
+   *
+   * \retval instance of WeaverAsyncImpl.
+   */
+  static WeaverAsyncImpl *getInstance();
+
+private:
+  /* Request queued for execution on the worker thread, reject completes
+   * it as failed without secure element access */
+  typedef struct Request {
+    uint64_t id;
+    std::function<void()> work;
+    std::function<void()> reject;
+  } Request;
+
+  /* Synchronous interface used by the worker thread */
+  WeaverInterface *mInterface = nullptr;
+  /* Lock & condition protecting the pending request queue */
+  std::mutex mQueueLock;
+  std::condition_variable mQueueCond;
+  std::deque<Request> mQueue;
+  /* Id to be assigned to next submitted request */
+  uint64_t mNextRequestId = 1;
+  /* Worker threads picking up the requests in submission order */
+  std::vector<std::thread> mWorkers;
+  /* Set from DeInit until next Init, requests are rejected & workers exit */
+  bool mIsStopped = false;
+
+  /* Queues the work and returns its request id. Rejected at once if
+   * stopped */
+  uint64_t submit(std::function<void()> work, std::function<void()> reject);
+  /* Worker thread loop */
+  void workerLoop();
+  /* Private constructor to make class singleton*/
+  WeaverAsyncImpl() = default;
+  /* Private destructor to make class singleton*/
+  ~WeaverAsyncImpl() = default;
+  /* Private copy constructor to make class singleton*/
+  WeaverAsyncImpl(const WeaverAsyncImpl &) = delete;
+  /* Private operator overload to make class singleton*/
+  WeaverAsyncImpl &operator=(const WeaverAsyncImpl &) = delete;
+
+  /* Private self instance for singleton purpose*/
+  static WeaverAsyncImpl *s_instance;
+  /* Private once flag (c++11) for singleton purpose.
+   * once_flag should pass to multiple calls of
+   * std::call_once allows those calls to coordinate with each other
+   * such a way only one will actually run to completion.
+   */
+  static std::once_flag s_instanceFlag;
+  /* Private function to create the instance of self class
+   * Same will be used for std::call_once
+   */
+  static void createInstance();
+};
+
+#endif /* _WEAVER_ASYNC_IMPL_H_ */
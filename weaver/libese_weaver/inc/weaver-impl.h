@@ -19,11 +19,36 @@
 #ifndef _WEAVER_IMPL_H_
 #define _WEAVER_IMPL_H_
 
+#include <IntervalTimer.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <list>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <weaver_interface.h>
-#include <weaver_parser.h>
+#include <weaver_parser-impl.h>
+#include <weaver_se_queue.h>
+#include <weaver_slot_snapshot.h>
+#include <weaver_throttle_ledger.h>
 #include <weaver_transport.h>
 
+/* Idle period after which an unused applet channel is closed.
+ * Setting it to 0 closes the channel after every operation */
+#define WEAVER_SESSION_IDLE_TIMEOUT (3 * 1000) // 3 secs, default value
+
+/* Period the channel is kept open after a prepare hint, default & upper bound */
+#define WEAVER_PREPARE_WINDOW (10 * 1000)     // 10 secs
+#define WEAVER_PREPARE_MAX_WINDOW (30 * 1000) // 30 secs
+
+/* Added to the session hold given to the transport, so that this class
+ * closes the channel before the transport idle timeout expires */
+#define WEAVER_SESSION_HOLD_MARGIN (500) // 500 msecs
+
+/* Time a request waits for the start up connection before proceeding */
+#define WEAVER_WARM_UP_TIMEOUT (5 * 1000) // 5 secs
+
 class WeaverImpl : public WeaverInterface {
 public:
   /**
@@ -52,7 +77,7 @@ public:
    * \retval This function return Weaver_STATUS_OK (0) in case of success
    *         In case of failure returns other Status_Weaver errorcodes.
    */
-  Status_Weaver Read(uint32_t slotId, const std::vector<uint8_t> &key,
+  Status_Weaver Read(uint32_t slotId, std::span<const uint8_t> key,
                      ReadRespInfo &readRespInfo) override;
 
   /**
@@ -64,8 +89,32 @@ public:
    * \retval This function return Weaver_STATUS_OK (0) in case of success
    *         In case of failure returns other Status_Weaver.
    */
-  Status_Weaver Write(uint32_t slotId, const std::vector<uint8_t> &key,
-                      const std::vector<uint8_t> &value) override;
+  Status_Weaver Write(uint32_t slotId, std::span<const uint8_t> key,
+                      std::span<const uint8_t> value) override;
+
+  /**
+   * \brief Function to perform multiple read/write operations in one session
+   * \param[in]    ops -          operations to be performed, in order
+   * \param[out]   results -      result of each operation, in the same order
+   *
+   * \retval This function return Weaver_STATUS_OK (0) if all operations were
+   *         processed, status of each operation is reported in results.
+   *         In case of failure returns other Status_Weaver.
+   */
+  Status_Weaver Batch(const std::vector<WeaverOperation> &ops,
+                      std::vector<WeaverOpResult> &results) override;
+
+  /**
+   * \brief Function to connect & select applet ahead of an imminent read,
+   * the channel is then kept open for the given window
+   * \param[in]    windowMs -     period in ms to keep the channel open,
+   *                              0 for default, bounded by
+   *                              WEAVER_PREPARE_MAX_WINDOW
+   *
+   * \retval This function return Weaver_STATUS_OK (0) in case of success
+   *         In case of failure returns other Status_Weaver.
+   */
+  Status_Weaver Prepare(uint32_t windowMs) override;
 
   /**
    * \brief Function to de-initilize Weaver Interface
@@ -75,6 +124,12 @@ public:
    */
   Status_Weaver DeInit() override;
 
+  /**
+   * \brief Function to dump state & statistics of Weaver Interface
+   * \param[in]    fd -           file descriptor to write to
+   */
+  void Dump(int fd) override;
+
   /**
    * \brief static function to get the singleton instance of WeaverImpl class
    *
@@ -82,13 +137,94 @@ public:
    */
   static WeaverImpl *getInstance();
 
+  /**
+   * \brief Function to configure the applet session idle period
+   * \param[in]    timeoutMs -    idle period in ms after which the channel is
+   *                              closed, 0 closes it after every operation
+   */
+  void setSessionIdleTimeout(uint32_t timeoutMs);
+
 private:
   /* Transport interface to be use for communication */
   WeaverTransport *mTransport;
-  /* Parser interface to frame weaver commands and parse response*/
-  WeaverParser *mParser;
-  /* Internal close api for transport close */
-  bool close();
+  /* Internal close api for transport close.
+   * Channel is kept open for the idle period unless forceClose is set */
+  bool close(bool forceClose = false);
+  /* Completes a deferred close for operations which didn't use the channel */
+  void settle();
+  /* Time in ms the session is to be kept open */
+  uint32_t sessionHoldTime();
+  /* Keeps the transport from closing the channel within the given hold */
+  void setTransportHold(uint32_t holdMs);
+  /* Idle timer callback to close the channel once session is idle */
+  static void sessionTimerFunc(union sigval arg);
+  /* Single serialization point for all secure element access, including
+   * the idle close of the session. Non-SE work must not wait on it */
+  WeaverSeQueue mSeQueue;
+  /* Timer to track idle period of the applet session */
+  IntervalTimer mSessionTimer;
+  /* Idle period in ms after which the channel is closed */
+  uint32_t mSessionIdleTimeout = WEAVER_SESSION_IDLE_TIMEOUT;
+  /* Time of the last operation completed on the session */
+  std::chrono::steady_clock::time_point mLastActivity;
+  /* End of the window requested by the last prepare hint */
+  std::chrono::steady_clock::time_point mPrepareUntil;
+  /* Set while the channel is left open for queued operations */
+  bool mIsCloseDeferred = false;
+  /* Slot information read from applet, valid while mIsSlotInfoCached is set */
+  std::mutex mSlotInfoLock;
+  SlotInfo mSlotInfo;
+  bool mIsSlotInfoCached = false;
+  /* Slot information of the previous run, answers until validated */
+  WeaverSlotSnapshot mSnapshot;
+  /* Transport event callback to invalidate cached applet state */
+  static void transportEventFunc(void *ctx, Transport_Event event);
+  /* Provides cached slot information, or the snapshot if allowed, returns
+   * false if not cached */
+  bool getCachedSlots(SlotInfo &slotInfo, bool allowSnapshot = true);
+  /* Reads slot information from applet unless cached meanwhile */
+  Status_Weaver fetchSlots(SlotInfo &slotInfo);
+  /* Internal getSlot transaction on the current session */
+  Status_Weaver transactGetSlots(SlotInfo &slotInfo);
+  /* Start up connection & applet selection, completed when mWarmUp is ready */
+  std::shared_future<void> mWarmUp;
+  void warmUp(std::shared_ptr<std::promise<void>> done);
+  /* Waits for a bounded time until start up connection completes */
+  void waitForWarmUp();
+  /* Checks slotId against cached slot count, if available */
+  bool isValidSlot(uint32_t slotId);
+  /* Consecutive read failures per slot, to report throttle timeouts */
+  WeaverThrottleLedger mThrottleLedger;
+  /* Answers read of a throttled slot without secure element access */
+  bool isThrottled(uint32_t slotId, ReadRespInfo &readRespInfo);
+  /* Read request in flight, shared by identical concurrent reads */
+  typedef struct InFlightRead {
+    uint32_t slotId;
+    WeaverSecureVector key;
+    std::promise<WeaverOpResult> promise;
+    std::shared_future<WeaverOpResult> result;
+  } InFlightRead;
+  std::mutex mInFlightLock;
+  std::list<std::shared_ptr<InFlightRead>> mInFlightReads;
+  /* Finds read in flight for same slot and key */
+  std::shared_ptr<InFlightRead> findInFlightRead(uint32_t slotId,
+                                                 std::span<const uint8_t> key);
+  /* Internal read/write transactions on the current session */
+  Status_Weaver transactRead(uint32_t slotId, std::span<const uint8_t> key,
+                             ReadRespInfo &readRespInfo);
+  Status_Weaver transactWrite(uint32_t slotId, std::span<const uint8_t> key,
+                              std::span<const uint8_t> value);
+  bool transactBatch(std::span<const WeaverOperation> ops,
+                     std::span<const size_t> indices,
+                     std::span<WeaverOpResult> results);
+  /* Updates throttle ledger with the read result, fills timeout */
+  void recordReadResult(uint32_t slotId, Status_Weaver status,
+                        ReadRespInfo &readRespInfo);
+  /* Capabilities announced in select response, in use only while owning
+   * mSeQueue. Renegotiated after the applet is selected again */
+  AppletCaps mAppletCaps = {};
+  std::atomic<bool> mIsAppletCapsStale = false;
+  void refreshAppletCaps();
   /* Private constructor to make class singleton*/
   WeaverImpl() = default;
   /* Private destructor to make class singleton*/
@@ -0,0 +1,89 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef _WEAVER_APPLET_PROFILE_H_
+#define _WEAVER_APPLET_PROFILE_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/* Compile time description of the weaver applet, used to specialize
+ * WeaverParserImpl. Variants derive from it and override what differs */
+struct WeaverAppletProfile {
+  /* byte info for GP header of weaver commands */
+  static constexpr uint8_t CLA = 0x80;
+  static constexpr uint8_t INS_GET_SLOT = 0x02;
+  static constexpr uint8_t INS_READ = 0x06;
+  static constexpr uint8_t INS_WRITE = 0x04;
+  static constexpr uint8_t P1 = 0x00;
+  static constexpr uint8_t P2 = 0x00;
+
+  /* Error code for weaver commands response */
+  static constexpr uint8_t SUCCESS_SW1 = 0x90;
+  static constexpr uint8_t SUCCESS_SW2 = 0x00;
+  static constexpr uint8_t INVALID_SLOT_SW1 = 0x6A;
+  static constexpr uint8_t INVALID_SLOT_SW2 = 0x88;
+  static constexpr uint8_t INVALID_P1P2_SW1 = 0x6A;
+  static constexpr uint8_t INVALID_P1P2_SW2 = 0x86;
+  static constexpr uint8_t INVALID_LENGTH_SW1 = 0x67;
+  static constexpr uint8_t INVALID_LENGTH_SW2 = 0x00;
+
+  /* Supported Size by Applet */
+  static constexpr size_t KEY_SIZE = 16;
+  static constexpr size_t VALUE_SIZE = 16;
+
+  /* For Applet Read Response TAG */
+  static constexpr uint8_t INCORRECT_KEY_TAG = 0x7F;
+  static constexpr uint8_t THROTTING_ENABLED_TAG = 0x76;
+  static constexpr uint8_t READ_SUCCESS_TAG = 0x00;
+
+  /* Tags of SELECT response, FCI template & proprietary data */
+  static constexpr uint8_t FCI_TAG = 0x6F;
+  static constexpr uint8_t FCI_PROPRIETARY_TAG = 0xA5;
+  /* Proprietary tag announcing the batch command, value is its INS. Batch
+   * command carries read & write records, each of the INS of the single
+   * command, slotId, key & value for write. Response carries one length
+   * prefixed record per command record, laid out as the single response */
+  static constexpr uint8_t BATCH_INS_TAG = 0xC1;
+  /* Proprietary tags announcing applet version (2 bytes, major & minor) and
+   * slot information, slot count (4 bytes), key & value size (1 byte each),
+   * sparing the getSlot command */
+  static constexpr uint8_t VERSION_TAG = 0xC0;
+  static constexpr uint8_t SLOT_COUNT_TAG = 0xC2;
+  static constexpr uint8_t KEY_SIZE_TAG = 0xC3;
+  static constexpr uint8_t VALUE_SIZE_TAG = 0xC4;
+
+  /* Applet ID to be used for Weaver */
+  static constexpr std::array<uint8_t, 12> AID = {
+      0xA0, 0x00, 0x00, 0x08, 0x44, 0x53, 0xF1, 0x27, 0x56, 0x18, 0x01, 0x00};
+};
+
+/* Applet variant storing 32 byte values */
+struct WeaverAppletProfileValue32 : WeaverAppletProfile {
+  static constexpr size_t VALUE_SIZE = 32;
+};
+
+/* Applet variant the HAL is built for */
+#ifdef WEAVER_APPLET_VALUE32
+typedef WeaverAppletProfileValue32 WeaverActiveProfile;
+#else
+typedef WeaverAppletProfile WeaverActiveProfile;
+#endif
+
+#endif /* _WEAVER_APPLET_PROFILE_H_ */
@@ -0,0 +1,166 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef _WEAVER_ASYNC_INTERFACE_H_
+#define _WEAVER_ASYNC_INTERFACE_H_
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <inttypes.h>
+#include <log/log.h>
+#include <weaver_common.h>
+
+/* Time to wait for completion of a request before reporting failure */
+#define WEAVER_REQUEST_TIMEOUT (10 * 1000) // 10 secs
+
+/* Completion callbacks of asynchronous weaver requests */
+typedef std::function<void(Status_Weaver status, const SlotInfo &slotInfo)>
+    GetSlotsCallback;
+typedef std::function<void(Status_Weaver status, const ReadRespInfo &readInfo)>
+    ReadCallback;
+typedef std::function<void(Status_Weaver status)> WriteCallback;
+typedef std::function<void(Status_Weaver status,
+                           const std::vector<WeaverOpResult> &results)>
+    BatchCallback;
+typedef std::function<void(Status_Weaver status)> PrepareCallback;
+
+class WeaverAsyncInterface {
+public:
+  /**
+   * \brief virtual Function to initilize Weaver Async Interface
+   *
+   * \retval This function return Weaver_STATUS_OK (0) in case of success
+   *         In case of failure returns other Status_Weaver.
+   */
+  virtual Status_Weaver Init() = 0;
+
+  /**
+   * \brief virtual Function to submit read of slot information
+   * \param[in]    cb -           callback invoked with slot information
+   *
+   * \retval This function return id of the submitted request
+   */
+  virtual uint64_t GetSlotsAsync(GetSlotsCallback cb) = 0;
+
+  /**
+   * \brief virtual Function to submit read of specific key & slotId
+   * \param[in]    slotId -       input slotId which's information to be read
+   * \param[in]    key -          input key which's information to be read
+   * \param[in]    cb -           callback invoked with read information
+   *
+   * \retval This function return id of the submitted request
+   */
+  virtual uint64_t ReadAsync(uint32_t slotId, std::span<const uint8_t> key,
+                             ReadCallback cb) = 0;
+
+  /**
+   * \brief virtual Function to submit write of value to specific key & slotId
+   * \param[in]    slotId -       input slotId where value to be write
+   * \param[in]    key -          input key where value to be write
+   * \param[in]    value -        input value which will be written
+   * \param[in]    cb -           callback invoked with write status
+   *
+   * \retval This function return id of the submitted request
+   */
+  virtual uint64_t WriteAsync(uint32_t slotId, std::span<const uint8_t> key,
+                              std::span<const uint8_t> value,
+                              WriteCallback cb) = 0;
+
+  /**
+   * \brief virtual Function to submit multiple read/write operations to be
+   *        performed in one session
+   * \param[in]    ops -          operations to be performed, in order
+   * \param[in]    cb -           callback invoked with result of operations
+   *
+   * \retval This function return id of the submitted request
+   */
+  virtual uint64_t BatchAsync(const std::vector<WeaverOperation> &ops,
+                              BatchCallback cb) = 0;
+
+  /**
+   * \brief virtual Function to submit connection & applet selection ahead of
+   * an imminent read
+   * \param[in]    windowMs -     period in ms to keep the channel open
+   * \param[in]    cb -           callback invoked with status
+   *
+   * \retval This function return id of the submitted request
+   */
+  virtual uint64_t PrepareAsync(uint32_t windowMs, PrepareCallback cb) = 0;
+
+  /**
+   * \brief virtual Function to cancel a submitted request
+   * \param[in]    requestId -    id of the request to be cancelled
+   *
+   * \retval This function return true if request was still pending and is
+   *         dropped without invoking its callback, false if it has already
+   *         been started or completed.
+   */
+  virtual bool Cancel(uint64_t requestId) = 0;
+
+  /**
+   * \brief Function to wait for completion of a submitted request, the
+   * request is cancelled if not completed within WEAVER_REQUEST_TIMEOUT
+   * \param[in]    future -       future set by the request callback
+   * \param[in]    requestId -    id of the submitted request
+   * \param[in]    waitIfStarted - a request already started can't be
+   *                              cancelled, wait until its completion instead
+   *                              of reporting failure
+   *
+   * \retval This function return true if the request completed, false if
+   *         it timed out.
+   */
+  template <typename T>
+  bool WaitForCompletion(std::future<T> &future, uint64_t requestId,
+                         bool waitIfStarted = false) {
+    if (future.wait_for(std::chrono::milliseconds(WEAVER_REQUEST_TIMEOUT)) ==
+        std::future_status::ready) {
+      return true;
+    }
+    ALOGE("Request (%" PRIu64 ") timed out", requestId);
+    if (Cancel(requestId) || !waitIfStarted) {
+      return false;
+    }
+    ALOGE("Request (%" PRIu64 ") already started, waiting for its result",
+          requestId);
+    future.wait();
+    return true;
+  }
+
+  /**
+   * \brief virtual Function to de-initilize Weaver Async Interface
+   *
+   * \retval This function return Weaver_STATUS_OK (0) in case of success
+   *         In case of failure returns other Status_Weaver.
+   */
+  virtual Status_Weaver DeInit() = 0;
+
+  /**
+   * \brief virtual Function to dump state & statistics of Weaver Async
+   * Interface
+   * \param[in]    fd -           file descriptor to write to
+   */
+  virtual void Dump(int fd) = 0;
+
+  /**
+   * \brief virtual destructor for Weaver Async Interface
+   */
+  virtual ~WeaverAsyncInterface(){};
+};
+
+#endif /* _WEAVER_ASYNC_INTERFACE_H_ */
@@ -0,0 +1,158 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef _WEAVER_BUFFER_POOL_H_
+#define _WEAVER_BUFFER_POOL_H_
+
+#include <mutex>
+#include <span>
+#include <vector>
+
+/* Size of an APDU slot, fits short APDUs and extended batch APDUs */
+#define WEAVER_POOL_SLOT_SIZE (1024)
+/* Number of APDU slots, command & response of an operation in progress */
+#define WEAVER_POOL_SLOTS (32)
+/* Size of a key & value slot, fits the largest key or value */
+#define WEAVER_POOL_SMALL_SLOT_SIZE (64)
+/* Number of key & value slots, requests queued & batch operations */
+#define WEAVER_POOL_SMALL_SLOTS (256)
+
+/* Pre-allocated arena of fixed size slots holding key & value material, in
+ * two size classes: small slots for keys & values, APDU slots for command &
+ * response buffers. The arena is locked in memory & excluded from core dumps,
+ * and slots are zeroed on release. Requests beyond slot size or pool capacity
+ * fall back to heap memory which is zeroed on release as well */
+class WeaverBufferPool {
+public:
+  /**
+   * \brief Function to allocate a buffer
+   * \param[in]    size -         size of the buffer in bytes
+   *
+   * \retval This function return the buffer, never NULL
+   */
+  void *allocate(size_t size);
+
+  /**
+   * \brief Function to zero & release a buffer
+   * \param[in]    ptr -          buffer returned by allocate
+   * \param[in]    size -         size passed to allocate
+   */
+  void deallocate(void *ptr, size_t size);
+
+  /**
+   * \brief Function to zero memory, not optimized away by the compiler
+   * \param[in]    ptr -          memory to be zeroed
+   * \param[in]    size -         size of the memory in bytes
+   */
+  static void wipe(void *ptr, size_t size);
+
+  /**
+   * \brief static function to get the singleton instance of WeaverBufferPool
+   * class
+   *
+   * \retval instance of WeaverBufferPool.
+   */
+  static WeaverBufferPool *getInstance();
+
+private:
+  /* Slots of one size, laid out contiguously in the arena */
+  typedef struct SlotClass {
+    size_t slotSize;
+    size_t slotCount;
+    uint8_t *base;
+    /* Free slots, reserved up front so that release doesn't allocate */
+    std::vector<uint8_t *> freeSlots;
+  } SlotClass;
+
+  std::mutex mLock;
+  uint8_t *mArena = nullptr;
+  size_t mArenaSize = 0;
+  SlotClass mSmallSlots = {WEAVER_POOL_SMALL_SLOT_SIZE, WEAVER_POOL_SMALL_SLOTS,
+                           nullptr, {}};
+  SlotClass mApduSlots = {WEAVER_POOL_SLOT_SIZE, WEAVER_POOL_SLOTS, nullptr, {}};
+
+  /* Splits the arena from base into the slots of the class */
+  static void initSlots(SlotClass &slots, uint8_t *base);
+  /* Returns the class ptr is a slot of, NULL if not a slot of the arena */
+  SlotClass *slotClassOf(const void *ptr);
+  /* Private constructor to make class singleton*/
+  WeaverBufferPool();
+  /* Private destructor to make class singleton*/
+  ~WeaverBufferPool() = default;
+  /* Private copy constructor to make class singleton*/
+  WeaverBufferPool(const WeaverBufferPool &) = delete;
+  /* Private operator overload to make class singleton*/
+  WeaverBufferPool &operator=(const WeaverBufferPool &) = delete;
+
+  /* Private self instance for singleton purpose*/
+  static WeaverBufferPool *s_instance;
+  /* Private once flag (c++11) for singleton purpose.
+   * once_flag should pass to multiple calls of
+   * std::call_once allows those calls to coordinate with each other
+   * such a way only one will actually run to completion.
+   */
+  static std::once_flag s_instanceFlag;
+  /* Private function to create the instance of self class
+   * Same will be used for std::call_once
+   */
+  static void createInstance();
+};
+
+/* Scoped slot of the pool, zeroed & released on destruction */
+class WeaverSecureBuffer {
+public:
+  WeaverSecureBuffer()
+      : mData((uint8_t *)WeaverBufferPool::getInstance()->allocate(
+            WEAVER_POOL_SLOT_SIZE)) {}
+  ~WeaverSecureBuffer() {
+    WeaverBufferPool::getInstance()->deallocate(mData, WEAVER_POOL_SLOT_SIZE);
+  }
+  WeaverSecureBuffer(const WeaverSecureBuffer &) = delete;
+  WeaverSecureBuffer &operator=(const WeaverSecureBuffer &) = delete;
+
+  /* View of the whole buffer */
+  std::span<uint8_t> span() { return {mData, WEAVER_POOL_SLOT_SIZE}; }
+
+private:
+  uint8_t *mData;
+};
+
+/* Allocator drawing container storage from the pool */
+template <typename T> struct WeaverSecureAllocator {
+  typedef T value_type;
+  WeaverSecureAllocator() = default;
+  template <typename U>
+  WeaverSecureAllocator(const WeaverSecureAllocator<U> &) {}
+  T *allocate(size_t n) {
+    return (T *)WeaverBufferPool::getInstance()->allocate(n * sizeof(T));
+  }
+  void deallocate(T *ptr, size_t n) {
+    WeaverBufferPool::getInstance()->deallocate(ptr, n * sizeof(T));
+  }
+  template <typename U> bool operator==(const WeaverSecureAllocator<U> &) const {
+    return true;
+  }
+  template <typename U> bool operator!=(const WeaverSecureAllocator<U> &) const {
+    return false;
+  }
+};
+
+/* Byte vector for key & value material */
+typedef std::vector<uint8_t, WeaverSecureAllocator<uint8_t>> WeaverSecureVector;
+
+#endif /* _WEAVER_BUFFER_POOL_H_ */
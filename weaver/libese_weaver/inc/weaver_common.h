@@ -19,7 +19,18 @@
 #ifndef _WEAVER_COMMON_H_
 #define _WEAVER_COMMON_H_
 
+#include <span>
 #include <vector>
+#include <weaver_buffer_pool.h>
+
+/* Capacity of command & response buffers, short APDU encoding */
+#define WEAVER_CMD_BUFFER_SIZE (5 + 255 + 1)  // header, data & Le
+#define WEAVER_RESP_BUFFER_SIZE (256 + 2)     // data & status word
+
+/* Commands & responses are framed in slots of the locked buffer pool */
+static_assert(WEAVER_POOL_SLOT_SIZE >= WEAVER_CMD_BUFFER_SIZE &&
+                  WEAVER_POOL_SLOT_SIZE >= WEAVER_RESP_BUFFER_SIZE,
+              "Pool slot can't hold an APDU");
 
 enum Status_Weaver {
   WEAVER_STATUS_OK,            // Success
@@ -41,7 +52,41 @@ typedef struct ReadRespInfo {
   /** The time to wait, in milliseconds, before making the next request. */
   uint32_t timeout;
   /** The value read from the slot or empty if the value was not read. */
-  std::vector<uint8_t> value;
+  WeaverSecureVector value;
 } ReadRespInfo;
 
+enum Weaver_Op_Type {
+  WEAVER_OP_READ,  // Read value of the slot
+  WEAVER_OP_WRITE, // Write key & value to the slot
+};
+
+typedef struct WeaverOperation {
+  /** The type of the operation. */
+  Weaver_Op_Type type;
+  /** The slot to be read or written. */
+  uint32_t slotId;
+  /** The key of the slot. */
+  WeaverSecureVector key;
+  /** The value to be written, unused for read. */
+  WeaverSecureVector value;
+} WeaverOperation;
+
+typedef struct AppletCaps {
+  /** Version of the applet, 0 if not announced. */
+  uint16_t version;
+  /** INS of the applet batch command, 0 if not supported. */
+  uint8_t batchIns;
+  /** True if slotInfo was announced, no getSlot command needed. */
+  bool hasSlotInfo;
+  /** The slot information, valid only if hasSlotInfo is set. */
+  SlotInfo slotInfo;
+} AppletCaps;
+
+typedef struct WeaverOpResult {
+  /** The status of the operation. */
+  Status_Weaver status;
+  /** The read information, valid only for read operation. */
+  ReadRespInfo readInfo;
+} WeaverOpResult;
+
 #endif /* _WEAVER_COMMON_H_ */
@@ -49,7 +49,7 @@ public:
    * \retval This function return Weaver_STATUS_OK (0) in case of success
    *         In case of failure returns other Status_Weaver errorcodes.
    */
-  virtual Status_Weaver Read(uint32_t slotId, const std::vector<uint8_t> &key,
+  virtual Status_Weaver Read(uint32_t slotId, std::span<const uint8_t> key,
                              ReadRespInfo &readRespInfo) = 0;
 
   /**
@@ -61,8 +61,31 @@ public:
    * \retval This function return Weaver_STATUS_OK (0) in case of success
    *         In case of failure returns other Status_Weaver.
    */
-  virtual Status_Weaver Write(uint32_t slotId, const std::vector<uint8_t> &key,
-                              const std::vector<uint8_t> &value) = 0;
+  virtual Status_Weaver Write(uint32_t slotId, std::span<const uint8_t> key,
+                              std::span<const uint8_t> value) = 0;
+
+  /**
+   * \brief virtual Function to perform multiple read/write operations in one
+   *        session
+   * \param[in]    ops -          operations to be performed, in order
+   * \param[out]   results -      result of each operation, in the same order
+   *
+   * \retval This function return Weaver_STATUS_OK (0) if all operations were
+   *         processed, status of each operation is reported in results.
+   *         In case of failure returns other Status_Weaver.
+   */
+  virtual Status_Weaver Batch(const std::vector<WeaverOperation> &ops,
+                              std::vector<WeaverOpResult> &results) = 0;
+
+  /**
+   * \brief virtual Function to connect & select applet ahead of an imminent
+   * read, the channel is then kept open for the given window
+   * \param[in]    windowMs -     period in ms to keep the channel open
+   *
+   * \retval This function return Weaver_STATUS_OK (0) in case of success
+   *         In case of failure returns other Status_Weaver.
+   */
+  virtual Status_Weaver Prepare(uint32_t windowMs) = 0;
 
   /**
    * \brief virtual Function to de-initilize Weaver Interface
@@ -72,6 +95,12 @@ public:
    */
   virtual Status_Weaver DeInit() = 0;
 
+  /**
+   * \brief virtual Function to dump state & statistics of Weaver Interface
+   * \param[in]    fd -           file descriptor to write to
+   */
+  virtual void Dump(int fd) = 0;
+
   /**
    * \brief virtual destructor for Weaver Interface
    */
@@ -19,58 +19,138 @@
 #ifndef _WEAVER_PARSER_IMPL_H_
 #define _WEAVER_PARSER_IMPL_H_
 
-#include <mutex>
-#include <weaver_parser.h>
+#include <algorithm>
+#include <weaver_applet_profile.h>
+#include <weaver_common.h>
 
-class WeaverParserImpl : public WeaverParser {
+/* Frames weaver commands & parses responses of the applet described by
+ * Profile. Command layouts are fixed at compile time, instances for known
+ * profiles are provided by weaver-parser-impl.cpp */
+template <typename Profile> class WeaverParserImpl {
 public:
+  /* Size of GP header of weaver commands, CLA, INS, P1 & P2 */
+  static constexpr size_t HEADER_SIZE = 4;
+  /* Size of status word at end of response */
+  static constexpr size_t RES_STATUS_SIZE = 2;
+  /* Size of tag at start of read response */
+  static constexpr size_t READ_ERR_CODE_SIZE = 1;
+
+  /* Size of framed commands, header, LC, data & LE */
+  static constexpr size_t GET_SLOT_CMD_SIZE = HEADER_SIZE + 1;
+  static constexpr size_t READ_CMD_SIZE =
+      HEADER_SIZE + 1 + sizeof(uint32_t) + Profile::KEY_SIZE + 1;
+  static constexpr size_t WRITE_CMD_SIZE = HEADER_SIZE + 1 + sizeof(uint32_t) +
+                                           Profile::KEY_SIZE +
+                                           Profile::VALUE_SIZE + 1;
+  static_assert(WRITE_CMD_SIZE <= WEAVER_CMD_BUFFER_SIZE,
+                "Write command exceeds short APDU");
+  static_assert(Profile::KEY_SIZE <= WEAVER_POOL_SMALL_SLOT_SIZE &&
+                    Profile::VALUE_SIZE <= WEAVER_POOL_SMALL_SLOT_SIZE,
+                "Pool small slot can't hold key or value");
+
+  /* Size of extended header, CLA, INS, P1, P2 & 3 byte LC, and of
+   * extended LE */
+  static constexpr size_t EXT_HEADER_SIZE = HEADER_SIZE + 3;
+  static constexpr size_t EXT_LE_SIZE = 2;
+  /* Size of batch command record, type, slotId, key & value for write */
+  static constexpr size_t BATCH_CMD_RECORD_SIZE =
+      1 + sizeof(uint32_t) + Profile::KEY_SIZE + Profile::VALUE_SIZE;
+  /* Size of batch response record, length & read response */
+  static constexpr size_t BATCH_RESP_RECORD_SIZE =
+      1 + READ_ERR_CODE_SIZE + Profile::VALUE_SIZE + RES_STATUS_SIZE;
+  /* Max operations of a batch command, for command & response to fit in
+   * a pool slot */
+  static constexpr size_t BATCH_MAX_OPS = std::min(
+      (WEAVER_POOL_SLOT_SIZE - EXT_HEADER_SIZE - EXT_LE_SIZE) /
+          BATCH_CMD_RECORD_SIZE,
+      (WEAVER_POOL_SLOT_SIZE - RES_STATUS_SIZE) / BATCH_RESP_RECORD_SIZE);
+  static_assert(BATCH_MAX_OPS > 1, "Pool slot can't hold a batch");
+
+  /* Fixed size buffers for framing read & write commands */
+  typedef std::span<uint8_t, READ_CMD_SIZE> ReadCmd;
+  typedef std::span<uint8_t, WRITE_CMD_SIZE> WriteCmd;
+
+  /* Command for getSlots, has no variable part */
+  static constexpr std::array<uint8_t, GET_SLOT_CMD_SIZE> kGetSlotCmd = {
+      Profile::CLA, Profile::INS_GET_SLOT, Profile::P1, Profile::P2,
+      sizeof(uint32_t)};
+
   /**
-   * \brief Function to Frame weaver applet request command for getSlots
+   * \brief Function to Frame weaver applet request command for read
    *
-   * \param[out]    request - framed getslots command as vector
+   * \param[in]     slotId  - input slotId to be used in read request.
+   * \param[in]     key     - input key to be used in read request.
+   * \param[out]    request - buffer to frame read command into
    *
    * \retval This function return true in case of success
    *         In case of failure returns false.
    */
-  bool FrameGetSlotCmd(std::vector<uint8_t> &request);
+  static bool FrameReadCmd(uint32_t slotId, std::span<const uint8_t> key,
+                           ReadCmd request);
 
   /**
-   * \brief Function to Frame weaver applet request command for open
+   * \brief Function to Frame weaver applet request command for write
    *
-   * \param[out]    request - framed open command as vector
+   * \param[in]     slotId  - input slotId to be used in write request.
+   * \param[in]     key     - input key to be used in write request.
+   * \param[in]     value   - input value to be used in write request.
+   * \param[out]    request - buffer to frame write command into
    *
    * \retval This function return true in case of success
    *         In case of failure returns false.
    */
-  bool FrameOpenCmd(std::vector<uint8_t> &request);
+  static bool FrameWriteCmd(uint32_t slotId, std::span<const uint8_t> key,
+                            std::span<const uint8_t> value, WriteCmd request);
 
   /**
-   * \brief Function to Frame weaver applet request command for read
+   * \brief Function to Frame applet batch command, extended length APDU is
+   * used if records don't fit a short APDU
    *
-   * \param[in]     slotId  - input slotId to be used in read request.
-   * \param[in]     key     - input key to be used in read request.
-   * \param[out]    request - framed read command as vector
+   * \param[in]     ins     - INS of the batch command, see ParseSelectResponse
+   * \param[in]     ops     - operations to pick the records from.
+   * \param[in]     indices - indices of the operations to be framed, in order,
+   *                         at most BATCH_MAX_OPS.
+   * \param[in,out] request - buffer to frame batch command into, narrowed to
+   *                         the framed command
    *
    * \retval This function return true in case of success
    *         In case of failure returns false.
    */
-  bool FrameReadCmd(uint32_t slotId, const std::vector<uint8_t> &key,
-                    std::vector<uint8_t> &request);
+  static bool FrameBatchCmd(uint8_t ins, std::span<const WeaverOperation> ops,
+                            std::span<const size_t> indices,
+                            std::span<uint8_t> &request);
 
   /**
-   * \brief Function to Frame weaver applet request command for write
+   * \brief Function to Parse select response for applet capabilities
    *
-   * \param[in]     slotId  - input slotId to be used in write request.
-   * \param[in]     key     - input key to be used in write request.
-   * \param[in]     value   - input value to be used in write request.
-   * \param[out]    request - framed write command as vector
+   * \param[in]     response  - select response of the applet.
+   * \param[out]    caps      - capabilities announced by the applet, none
+   * if not announced.
    *
    * \retval This function return true in case of success
    *         In case of failure returns false.
    */
-  bool FrameWriteCmd(uint32_t slotId, const std::vector<uint8_t> &key,
-                     const std::vector<uint8_t> &value,
-                     std::vector<uint8_t> &request);
+  static bool ParseSelectResponse(std::span<const uint8_t> response,
+                                  AppletCaps &caps);
+
+  /**
+   * \brief Function to Parse applet batch response
+   *
+   * \param[in]     response  - response from applet.
+   * \param[in]     ops       - operations the command was framed from.
+   * \param[in]     indices   - indices of the framed operations, in order.
+   * \param[out]    results   - result of each framed operation, at same index
+   * as the operation.
+   *
+   * \retval This function return Weaver_STATUS_OK (0) if applet processed the
+   *         batch, status of each operation is reported in results.
+   *         In case of failure returns other Status_Weaver, operations without
+   *         a valid record are then reported failed in results.
+   */
+  static Status_Weaver ParseBatchResponse(std::span<const uint8_t> response,
+                                          std::span<const WeaverOperation> ops,
+                                          std::span<const size_t> indices,
+                                          std::span<WeaverOpResult> results);
 
   /**
    * \brief Function to Parse getSlots response
@@ -82,8 +162,8 @@ public:
    * \retval This function return true in case of success
    *         In case of failure returns false.
    */
-  Status_Weaver ParseSlotInfo(std::vector<uint8_t> response,
-                              SlotInfo &slotInfo);
+  static Status_Weaver ParseSlotInfo(std::span<const uint8_t> response,
+                                     SlotInfo &slotInfo);
 
   /**
    * \brief Function to Parse read response
@@ -95,8 +175,8 @@ public:
    * \retval This function return true in case of success
    *         In case of failure returns false.
    */
-  Status_Weaver ParseReadInfo(std::vector<uint8_t> response,
-                              ReadRespInfo &readInfo);
+  static Status_Weaver ParseReadInfo(std::span<const uint8_t> response,
+                                     ReadRespInfo &readInfo);
 
   /**
    * \brief Function to check if response from applet is Success or not
@@ -106,7 +186,7 @@ public:
    * \retval This function return true if response code from applet is success
    *         and false in other cases.
    */
-  bool isSuccess(std::vector<uint8_t> response);
+  static bool isSuccess(std::span<const uint8_t> response);
 
   /**
    * \brief Function to get Weaver Applet ID
@@ -116,15 +196,7 @@ public:
    * \retval This function return true in case of success
    *         In case of failure returns false.
    */
-  bool getAppletId(std::vector<uint8_t> &aid);
-
-  /**
-   * \brief static function to get the singleton instance of WeaverParserImpl
-   * class
-   *
-   * \retval instance of WeaverParserImpl.
-   */
-  static WeaverParserImpl *getInstance();
+  static bool getAppletId(std::vector<uint8_t> &aid);
 
 private:
   /* Internal error codes for Parser Implementation */
@@ -144,28 +216,25 @@ private:
    *
    * \retval This function return errorcode from APP_ERR_CODE type
    */
-  APP_ERR_CODE checkStatus(std::vector<uint8_t> response);
-  /* Private constructor to make class singleton*/
-  WeaverParserImpl() = default;
-  /* Private destructor to make class singleton*/
-  ~WeaverParserImpl() = default;
-  /* Private copy constructor to make class singleton*/
-  WeaverParserImpl(const WeaverParserImpl &) = delete;
-  /* Private operator overload to make class singleton*/
-  WeaverParserImpl &operator=(const WeaverParserImpl &) = delete;
-
-  /* Private self instance for singleton purpose*/
-  static WeaverParserImpl *s_instance;
-  /* Private once flag (c++11) for singleton purpose.
-   * once_flag should pass to multiple calls of
-   * std::call_once allows those calls to coordinate with each other
-   * such a way only one will actually run to completion.
-   */
-  static std::once_flag s_instanceFlag;
-  /* Private function to create the instance of self class
-   * Same will be used for std::call_once
-   */
-  static void createInstance();
+  static APP_ERR_CODE checkStatus(std::span<const uint8_t> response);
+
+  /* Frames header & LC, short or extended as needed by lc */
+  static size_t frameHeader(uint8_t ins, size_t lc, std::span<uint8_t> request);
+  /* Frames slotId & key common to read, write & batch records */
+  static size_t frameSlotKey(uint32_t slotId, std::span<const uint8_t> key,
+                             std::span<uint8_t> request);
+  /* Finds a single byte tag in BER-TLV data, searching constructed tags */
+  static bool findTag(std::span<const uint8_t> data, uint8_t tag,
+                      std::span<const uint8_t> &value);
+
+  /* Only static members, not to be instantiated */
+  WeaverParserImpl() = delete;
 };
 
+/* Parser of the applet variant the HAL is built for */
+typedef WeaverParserImpl<WeaverActiveProfile> WeaverParser;
+
+extern template class WeaverParserImpl<WeaverAppletProfile>;
+extern template class WeaverParserImpl<WeaverAppletProfileValue32>;
+
 #endif /* _WEAVER_PARSER_IMPL_H_ */
@@ -0,0 +1,127 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef _WEAVER_SE_QUEUE_H_
+#define _WEAVER_SE_QUEUE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+
+/* Priority classes of secure element access, highest first */
+enum SeAccess_Priority {
+  SE_PRIORITY_READ,         // Interactive read, user waiting for unlock
+  SE_PRIORITY_WRITE,        // Enrolment & credential change
+  SE_PRIORITY_HOUSEKEEPING, // getSlots, warm-up & session close
+  SE_PRIORITY_MAX,
+};
+
+/* Waiting time after which a waiter is promoted by one priority class */
+#define SE_QUEUE_AGING_STEP (500) // 500 msecs
+
+/* Number of buckets of the queue wait time histogram */
+#define SE_QUEUE_WAIT_BUCKETS 12
+
+/* Queue wait time statistics of one priority class */
+typedef struct WeaverSeQueueStats {
+  /** The number of grants of secure element access. */
+  uint64_t count;
+  /** The accumulated queue wait time, in microseconds. */
+  uint64_t totalWaitUs;
+  /** The longest queue wait time, in microseconds. */
+  uint64_t maxWaitUs;
+  /** The number of grants per wait time bucket. */
+  uint64_t histogram[SE_QUEUE_WAIT_BUCKETS];
+} WeaverSeQueueStats;
+
+/* Serialization point in front of the secure element.
+ * Callers are granted access one at a time, by priority class and in order
+ * of arrival within a class. Waiters age so lower classes aren't starved */
+class WeaverSeQueue {
+public:
+  /**
+   * \brief Function to wait until caller owns the secure element
+   * \param[in]    priority -     priority class of the caller
+   */
+  void acquire(SeAccess_Priority priority);
+
+  /**
+   * \brief Function to hand over the secure element to next waiting caller
+   */
+  void release();
+
+  /**
+   * \brief Function to get number of callers waiting for the secure element
+   *
+   * \retval This function return number of waiting callers
+   */
+  size_t pending();
+
+  /**
+   * \brief Function to get queue wait statistics of a priority class
+   * \param[in]    priority -     priority class
+   * \param[out]   stats -        queue wait statistics of the class
+   */
+  void getStats(SeAccess_Priority priority, WeaverSeQueueStats &stats);
+
+  /**
+   * \brief Function to dump queue wait statistics of all priority classes
+   * \param[in]    fd -           file descriptor to write to
+   */
+  void dump(int fd);
+
+private:
+  /* Caller waiting for the secure element */
+  typedef struct Waiter {
+    uint64_t ticket;
+    SeAccess_Priority priority;
+    std::chrono::steady_clock::time_point arrival;
+  } Waiter;
+
+  std::mutex mLock;
+  std::condition_variable mCond;
+  std::list<Waiter> mWaiters;
+  /* Ticket to be handed to next arriving caller */
+  uint64_t mNextTicket = 1;
+  /* Ticket of the caller owning the secure element, 0 if none */
+  uint64_t mOwnerTicket = 0;
+  WeaverSeQueueStats mStats[SE_PRIORITY_MAX] = {};
+
+  /* Grants access to the waiter with best aged priority */
+  void grantNext();
+  /* Records queue wait time of a granted caller */
+  void recordWait(SeAccess_Priority priority, uint64_t waitUs);
+};
+
+/* Scoped ownership of the secure element */
+class WeaverSeAccess {
+public:
+  WeaverSeAccess(WeaverSeQueue &queue, SeAccess_Priority priority)
+      : mQueue(queue) {
+    mQueue.acquire(priority);
+  }
+  ~WeaverSeAccess() { mQueue.release(); }
+  WeaverSeAccess(const WeaverSeAccess &) = delete;
+  WeaverSeAccess &operator=(const WeaverSeAccess &) = delete;
+
+private:
+  WeaverSeQueue &mQueue;
+};
+
+#endif /* _WEAVER_SE_QUEUE_H_ */
@@ -0,0 +1,96 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef _WEAVER_SLOT_SNAPSHOT_H_
+#define _WEAVER_SLOT_SNAPSHOT_H_
+
+#include <mutex>
+#include <weaver_common.h>
+
+/* Snapshot file, directory is created by the service init script */
+#define WEAVER_SNAPSHOT_PATH "/data/vendor/weaver/slot_info"
+/* Layout version of the snapshot file, bump on any change of the record */
+#define WEAVER_SNAPSHOT_FORMAT (1)
+
+/* Persisted copy of the last slot information validated against the
+ * applet, so that slot information can be answered after a restart of the
+ * service before the secure element is reachable. The snapshot is usable
+ * until validated slot information differs from it or the applet changes */
+class WeaverSlotSnapshot {
+public:
+  /**
+   * \brief Function to load the snapshot from file
+   *
+   * \retval This function return true if a valid snapshot was loaded
+   *         In case of missing or corrupt file returns false.
+   */
+  bool load();
+
+  /**
+   * \brief Function to get the slot information of the snapshot
+   * \param[out]   slotInfo -     slot information of the snapshot
+   *
+   * \retval This function return true if the snapshot is usable
+   *         and false in other cases.
+   */
+  bool get(SlotInfo &slotInfo);
+
+  /**
+   * \brief Function to update the snapshot with slot information validated
+   * against the applet, file is written only if the information changed
+   * \param[in]    slotInfo -     slot information read from applet
+   * \param[in]    appletVersion - version of the applet, 0 if unknown
+   */
+  void update(const SlotInfo &slotInfo, uint16_t appletVersion);
+
+  /**
+   * \brief Function to invalidate the snapshot if the applet version differs
+   * \param[in]    appletVersion - version of the applet, 0 if unknown
+   */
+  void checkVersion(uint16_t appletVersion);
+
+  /**
+   * \brief Function to invalidate the snapshot and remove the file
+   */
+  void invalidate();
+
+private:
+  /* Record stored in the snapshot file */
+  typedef struct Record {
+    uint32_t magic;
+    uint16_t format;
+    uint16_t appletVersion;
+    uint32_t slots;
+    uint32_t keySize;
+    uint32_t valueSize;
+    uint32_t checksum; // over all preceding fields
+  } Record;
+
+  std::mutex mLock;
+  Record mRecord = {};
+  bool mIsUsable = false;
+
+  /* Checksum of the record, excluding the checksum field */
+  static uint32_t computeChecksum(const Record &record);
+  /* Writes the record to file atomically, caller holds mLock */
+  bool write(const Record &record);
+  /* Invalidates the snapshot, caller holds mLock */
+  void invalidateLocked();
+};
+
+#endif /* _WEAVER_SLOT_SNAPSHOT_H_ */
@@ -0,0 +1,111 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+#ifndef _WEAVER_THROTTLE_LEDGER_H_
+#define _WEAVER_THROTTLE_LEDGER_H_
+
+#include <chrono>
+#include <map>
+#include <mutex>
+
+/* Upper bound of the failure count tracked per slot */
+#define WEAVER_THROTTLE_MAX_FAILURES (0xFFFF)
+
+/* Host side record of consecutive failed reads per slot.
+ * Mirrors the Weaver throttling schedule so that clients are given the
+ * actual time to wait, and reads inside a throttle window are answered
+ * without a secure element round trip. Only counts and times are kept,
+ * never keys nor values */
+class WeaverThrottleLedger {
+public:
+  /**
+   * \brief Function to get remaining throttle time of a slot
+   * \param[in]    slotId -       slot to be checked
+   *
+   * \retval This function return time in ms before the slot may be read
+   *         again, 0 if the slot is not throttled.
+   */
+  uint32_t remaining(uint32_t slotId);
+
+  /**
+   * \brief Function to record a failed read with incorrect key
+   * \param[in]    slotId -       slot which failed
+   *
+   * \retval This function return time in ms to wait before next read.
+   */
+  uint32_t recordFailure(uint32_t slotId);
+
+  /**
+   * \brief Function to record a read rejected by the applet as throttled
+   * \param[in]    slotId -       slot which is throttled
+   *
+   * \retval This function return time in ms to wait before next read.
+   */
+  uint32_t recordThrottle(uint32_t slotId);
+
+  /**
+   * \brief Function to reset the record of a slot, on successful read or
+   * write of the slot
+   * \param[in]    slotId -       slot to be reset
+   */
+  void reset(uint32_t slotId);
+
+  /**
+   * \brief Function to reset the record of all slots
+   */
+  void clear();
+
+  /**
+   * \brief Function to compute timeout of the Weaver throttling schedule
+   * \param[in]    failures -     number of consecutive failures
+   *
+   * \retval This function return time in ms to wait before next attempt.
+   */
+  static constexpr uint32_t computeTimeout(uint32_t failures) {
+    constexpr uint32_t kThirtySeconds = 30 * 1000;
+    constexpr uint32_t kOneDay = 24 * 60 * 60 * 1000;
+    if (failures == 0) {
+      return 0;
+    } else if (failures <= 10) {
+      /* every 5th failure within the first 10 */
+      return (failures % 5 == 0) ? kThirtySeconds : 0;
+    } else if (failures <= 30) {
+      return kThirtySeconds;
+    } else if (failures < 140) {
+      /* doubles every 10 failures */
+      return kThirtySeconds << ((failures - 30) / 10);
+    }
+    return kOneDay;
+  }
+
+private:
+  /* Record of consecutive failures of a slot */
+  typedef struct Entry {
+    uint32_t failures;
+    std::chrono::steady_clock::time_point windowEnd;
+  } Entry;
+
+  std::mutex mLock;
+  std::map<uint32_t, Entry> mEntries;
+
+  /* Opens throttle window of timeoutMs for the entry, caller holds mLock */
+  static void openWindow(Entry &entry, uint32_t timeoutMs);
+};
+
+#endif /* _WEAVER_THROTTLE_LEDGER_H_ */
@@ -32,19 +32,20 @@ public:
    * \retval This function return true in case of success
    *         In case of failure returns false.
    */
-  bool Init(std::vector<uint8_t> aid) override;
+  bool Init(const std::vector<uint8_t> &aid) override;
 
   /**
    * \brief Function to open applet connection
    *
    * \param[in]    data -         command for open applet
-   * \param[out]   resp -         response from applet
+   * \param[in,out] resp -        buffer for response from applet, narrowed to
+   *                              the response length
    *
    * \retval This function return true in case of success
    *         In case of failure returns false.
    */
-  bool OpenApplet(std::vector<uint8_t> data,
-                  std::vector<uint8_t> &resp) override;
+  bool OpenApplet(std::span<const uint8_t> data,
+                  std::span<uint8_t> &resp) override;
 
   /**
    * \brief Function to close applet connection
@@ -58,12 +59,23 @@ public:
    * \brief Function to send commands to applet
    *
    * \param[in]    data -         command to be send to applet
-   * \param[out]   resp -         response from applet
+   * \param[in,out] resp -        buffer for response from applet, narrowed to
+   *                              the response length
    *
    * \retval This function return true in case of success
    *         In case of failure returns false.
    */
-  bool Send(std::vector<uint8_t> data, std::vector<uint8_t> &resp) override;
+  bool Send(std::span<const uint8_t> data, std::span<uint8_t> &resp) override;
+
+  /**
+   * \brief Function to get select response of the applet
+   *
+   * \param[out]   resp -         select response of the last opened channel
+   *
+   * \retval This function return true in case of success
+   *         In case of failure returns false.
+   */
+  bool GetSelectResponse(std::vector<uint8_t> &resp) override;
 
   /**
    * \brief Function to de-initilize Weaver Transport Interface
@@ -73,6 +85,22 @@ public:
    */
   bool DeInit() override;
 
+  /**
+   * \brief Function to register callback for transport events
+   *
+   * \param[in]    ctx -          context passed back to the callback
+   * \param[in]    cb -           callback to be invoked on transport events
+   */
+  void RegisterEventCallback(void *ctx, WEAVER_EVENT_CB cb) override;
+
+  /**
+   * \brief Function to set the lower bound of the channel idle timeout
+   *
+   * \param[in]    timeoutMs -    period in ms the transport keeps an idle
+   *                              channel open at least, 0 for none
+   */
+  void SetMinSessionTimeout(uint32_t timeoutMs) override;
+
   /**
    * \brief static function to get the singleton instance of WeaverTransportImpl
    * class
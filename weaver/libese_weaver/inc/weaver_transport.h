@@ -19,8 +19,18 @@
 #ifndef _WEAVER_TRANSPORT_H_
 #define _WEAVER_TRANSPORT_H_
 
+#include <span>
 #include <vector>
 
+/* Events reported by transport which may affect cached applet state */
+enum Transport_Event {
+  TRANSPORT_EVENT_SE_CONNECTED,   // Secure element connection (re)established
+  TRANSPORT_EVENT_APPLET_UPDATE,  // Applet update detected during select
+  TRANSPORT_EVENT_APPLET_SELECTED, // Applet selected, select response updated
+};
+
+typedef void (*WEAVER_EVENT_CB)(void *ctx, Transport_Event event);
+
 class WeaverTransport {
 public:
   /**
@@ -31,19 +41,20 @@ public:
    * \retval This function return true in case of success
    *         In case of failure returns false.
    */
-  virtual bool Init(std::vector<uint8_t> aid) = 0;
+  virtual bool Init(const std::vector<uint8_t> &aid) = 0;
 
   /**
    * \brief virtual Function to open applet connection
    *
    * \param[in]    data -         command for open applet
-   * \param[out]   resp -         response from applet
+   * \param[in,out] resp -        buffer for response from applet, narrowed to
+   *                              the response length
    *
    * \retval This function return true in case of success
    *         In case of failure returns false.
    */
-  virtual bool OpenApplet(std::vector<uint8_t> data,
-                          std::vector<uint8_t> &resp) = 0;
+  virtual bool OpenApplet(std::span<const uint8_t> data,
+                          std::span<uint8_t> &resp) = 0;
 
   /**
    * \brief virtual Function to close applet connection
@@ -57,12 +68,23 @@ public:
    * \brief virtual Function to send commands to applet
    *
    * \param[in]    data -         command to be send to applet
-   * \param[out]   resp -         response from applet
+   * \param[in,out] resp -        buffer for response from applet, narrowed to
+   *                              the response length
+   *
+   * \retval This function return true in case of success
+   *         In case of failure returns false.
+   */
+  virtual bool Send(std::span<const uint8_t> data, std::span<uint8_t> &resp) = 0;
+
+  /**
+   * \brief virtual Function to get select response of the applet
+   *
+   * \param[out]   resp -         select response of the last opened channel
    *
    * \retval This function return true in case of success
    *         In case of failure returns false.
    */
-  virtual bool Send(std::vector<uint8_t> data, std::vector<uint8_t> &resp) = 0;
+  virtual bool GetSelectResponse(std::vector<uint8_t> &resp) = 0;
 
   /**
    * \brief virtual Function to de-initilize Weaver Transport Interface
@@ -72,6 +94,22 @@ public:
    */
   virtual bool DeInit() = 0;
 
+  /**
+   * \brief virtual Function to register callback for transport events
+   *
+   * \param[in]    ctx -          context passed back to the callback
+   * \param[in]    cb -           callback to be invoked on transport events
+   */
+  virtual void RegisterEventCallback(void *ctx, WEAVER_EVENT_CB cb) = 0;
+
+  /**
+   * \brief virtual Function to set the lower bound of the channel idle timeout
+   *
+   * \param[in]    timeoutMs -    period in ms the transport keeps an idle
+   *                              channel open at least, 0 for none
+   */
+  virtual void SetMinSessionTimeout(uint32_t timeoutMs) = 0;
+
   /**
    * \brief virtual destructor for Weaver Transport Interface
    */
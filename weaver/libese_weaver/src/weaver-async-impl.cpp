@@ -0,0 +1,273 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "weaver-async-impl"
+#include <inttypes.h>
+#include <stdio.h>
+#include <weaver-async-impl.h>
+#include <weaver-impl.h>
+#include <weaver_utils.h>
+
+WeaverAsyncImpl *WeaverAsyncImpl::s_instance = NULL;
+std::once_flag WeaverAsyncImpl::s_instanceFlag;
+
+/**
+ * \brief static function to get the singleton instance of WeaverAsyncImpl
+ * class
+ *
+ * \retval instance of WeaverAsyncImpl.
+ */
+WeaverAsyncImpl *WeaverAsyncImpl::getInstance() {
+  /* call_once c++11 api which executes the passed function ptr exactly once,
+   * even if called concurrently, from several threads
+   */
+  std::call_once(s_instanceFlag, &WeaverAsyncImpl::createInstance);
+  return s_instance;
+}
+
+/* Private function to create the instance of self class
+ * Same will be used for std::call_once
+ */
+void WeaverAsyncImpl::createInstance() {
+  LOG_D(TAG, "Entry");
+  s_instance = new WeaverAsyncImpl;
+  LOG_D(TAG, "Exit");
+}
+
+/**
+ * \brief Function to initilize Weaver Async Interface
+ *
+ * \retval This function return Weaver_STATUS_OK (0) in case of success
+ *         In case of failure returns other Status_Weaver.
+ */
+Status_Weaver WeaverAsyncImpl::Init() {
+  LOG_D(TAG, "Entry");
+  mInterface = WeaverImpl::getInstance();
+  RETURN_IF_NULL(mInterface, WEAVER_STATUS_FAILED, "Interface is NULL");
+  Status_Weaver status = mInterface->Init();
+  std::lock_guard<std::mutex> lock(mQueueLock);
+  mIsStopped = false;
+  while (mWorkers.size() < WEAVER_ASYNC_WORKERS) {
+    mWorkers.emplace_back(&WeaverAsyncImpl::workerLoop, this);
+  }
+  LOG_D(TAG, "Exit");
+  return status;
+}
+
+/**
+ * \brief Function to submit read of slot information
+ * \param[in]    cb -           callback invoked with slot information
+ *
+ * \retval This function return id of the submitted request
+ */
+uint64_t WeaverAsyncImpl::GetSlotsAsync(GetSlotsCallback cb) {
+  return submit(
+      [this, cb]() {
+        SlotInfo slotInfo = {};
+        Status_Weaver status = mInterface->GetSlots(slotInfo);
+        cb(status, slotInfo);
+      },
+      [cb]() { cb(WEAVER_STATUS_FAILED, SlotInfo{}); });
+}
+
+/**
+ * \brief Function to submit read of specific key & slotId
+ * \param[in]    slotId -       input slotId which's information to be read
+ * \param[in]    key -          input key which's information to be read
+ * \param[in]    cb -           callback invoked with read information
+ *
+ * \retval This function return id of the submitted request
+ */
+uint64_t WeaverAsyncImpl::ReadAsync(uint32_t slotId,
+                                    std::span<const uint8_t> key,
+                                    ReadCallback cb) {
+  /* queued copy of the key is drawn from the locked pool */
+  return submit(
+      [this, slotId, key = WeaverSecureVector(key.begin(), key.end()), cb]() {
+        ReadRespInfo readInfo = {};
+        Status_Weaver status = mInterface->Read(slotId, key, readInfo);
+        cb(status, readInfo);
+      },
+      [cb]() { cb(WEAVER_STATUS_FAILED, ReadRespInfo{}); });
+}
+
+/**
+ * \brief Function to submit write of value to specific key & slotId
+ * \param[in]    slotId -       input slotId where value to be write
+ * \param[in]    key -          input key where value to be write
+ * \param[in]    value -        input value which will be written
+ * \param[in]    cb -           callback invoked with write status
+ *
+ * \retval This function return id of the submitted request
+ */
+uint64_t WeaverAsyncImpl::WriteAsync(uint32_t slotId,
+                                     std::span<const uint8_t> key,
+                                     std::span<const uint8_t> value,
+                                     WriteCallback cb) {
+  /* queued copies of key & value are drawn from the locked pool */
+  return submit(
+      [this, slotId, key = WeaverSecureVector(key.begin(), key.end()),
+       value = WeaverSecureVector(value.begin(), value.end()), cb]() {
+        cb(mInterface->Write(slotId, key, value));
+      },
+      [cb]() { cb(WEAVER_STATUS_FAILED); });
+}
+
+/**
+ * \brief Function to submit multiple read/write operations to be performed
+ *        in one session
+ * \param[in]    ops -          operations to be performed, in order
+ * \param[in]    cb -           callback invoked with result of operations
+ *
+ * \retval This function return id of the submitted request
+ */
+uint64_t WeaverAsyncImpl::BatchAsync(const std::vector<WeaverOperation> &ops,
+                                     BatchCallback cb) {
+  return submit(
+      [this, ops, cb]() {
+        std::vector<WeaverOpResult> results;
+        Status_Weaver status = mInterface->Batch(ops, results);
+        cb(status, results);
+      },
+      [cb]() { cb(WEAVER_STATUS_FAILED, std::vector<WeaverOpResult>()); });
+}
+
+/**
+ * \brief Function to submit connection & applet selection ahead of an
+ * imminent read
+ * \param[in]    windowMs -     period in ms to keep the channel open
+ * \param[in]    cb -           callback invoked with status
+ *
+ * \retval This function return id of the submitted request
+ */
+uint64_t WeaverAsyncImpl::PrepareAsync(uint32_t windowMs, PrepareCallback cb) {
+  return submit([this, windowMs, cb]() { cb(mInterface->Prepare(windowMs)); },
+                [cb]() { cb(WEAVER_STATUS_FAILED); });
+}
+
+/**
+ * \brief Function to cancel a submitted request
+ * \param[in]    requestId -    id of the request to be cancelled
+ *
+ * \retval This function return true if request was still pending and is
+ *         dropped without invoking its callback, false if it has already
+ *         been started or completed.
+ */
+bool WeaverAsyncImpl::Cancel(uint64_t requestId) {
+  LOG_D(TAG, "Entry");
+  std::lock_guard<std::mutex> lock(mQueueLock);
+  for (auto it = mQueue.begin(); it != mQueue.end(); it++) {
+    if (it->id == requestId) {
+      mQueue.erase(it);
+      LOG_D(TAG, "Request (%" PRIu64 ") cancelled", requestId);
+      return true;
+    }
+  }
+  LOG_D(TAG, "Exit");
+  return false;
+}
+
+/**
+ * \brief Function to de-initilize Weaver Async Interface. New requests are
+ * refused and pending ones completed as failed until next Init, started ones
+ * are waited for before the transport is closed
+ *
+ * \retval This function return Weaver_STATUS_OK (0) in case of success
+ *         In case of failure returns other Status_Weaver.
+ */
+Status_Weaver WeaverAsyncImpl::DeInit() {
+  LOG_D(TAG, "Entry");
+  RETURN_IF_NULL(mInterface, WEAVER_STATUS_FAILED, "Interface is NULL");
+  std::deque<Request> pending;
+  std::vector<std::thread> workers;
+  {
+    std::lock_guard<std::mutex> lock(mQueueLock);
+    mIsStopped = true;
+    pending.swap(mQueue);
+    workers.swap(mWorkers);
+  }
+  mQueueCond.notify_all();
+  for (Request &request : pending) {
+    LOG_D(TAG, "Request (%" PRIu64 ") rejected", request.id);
+    request.reject();
+  }
+  /* workers exit once done with the request they started */
+  for (std::thread &worker : workers) {
+    if (worker.get_id() == std::this_thread::get_id()) {
+      worker.detach();
+    } else {
+      worker.join();
+    }
+  }
+  Status_Weaver status = mInterface->DeInit();
+  LOG_D(TAG, "Exit");
+  return status;
+}
+
+/**
+ * \brief Function to dump state & statistics of Weaver Async Interface
+ * \param[in]    fd -           file descriptor to write to
+ */
+void WeaverAsyncImpl::Dump(int fd) {
+  {
+    std::lock_guard<std::mutex> lock(mQueueLock);
+    dprintf(fd, "Async requests: %zu queued\n", mQueue.size());
+  }
+  if (mInterface != NULL) {
+    mInterface->Dump(fd);
+  }
+}
+
+/* Queues the work and returns its request id. Rejected at once if stopped */
+uint64_t WeaverAsyncImpl::submit(std::function<void()> work,
+                                 std::function<void()> reject) {
+  std::unique_lock<std::mutex> lock(mQueueLock);
+  uint64_t requestId = mNextRequestId++;
+  if (mIsStopped) {
+    lock.unlock();
+    LOG_E(TAG, "Request (%" PRIu64 ") rejected, not initialized", requestId);
+    reject();
+    return requestId;
+  }
+  mQueue.push_back({requestId, std::move(work), std::move(reject)});
+  mQueueCond.notify_one();
+  LOG_D(TAG, "Request (%" PRIu64 ") queued, pending (%zu)", requestId,
+        mQueue.size());
+  return requestId;
+}
+
+/* Worker thread loop, picks up the requests in submission order so that
+ * binder threads are not blocked in the secure element transaction */
+void WeaverAsyncImpl::workerLoop() {
+  LOG_D(TAG, "Worker started");
+  while (true) {
+    Request request;
+    {
+      std::unique_lock<std::mutex> lock(mQueueLock);
+      mQueueCond.wait(lock, [this] { return !mQueue.empty() || mIsStopped; });
+      if (mIsStopped) {
+        LOG_D(TAG, "Worker stopped");
+        return;
+      }
+      request = std::move(mQueue.front());
+      mQueue.pop_front();
+    }
+    LOG_D(TAG, "Request (%" PRIu64 ") started", request.id);
+    request.work();
+  }
+}
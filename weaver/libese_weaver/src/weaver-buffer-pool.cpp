@@ -0,0 +1,154 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "weaver-buffer-pool"
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <new>
+#include <weaver_buffer_pool.h>
+#include <weaver_utils.h>
+
+WeaverBufferPool *WeaverBufferPool::s_instance = NULL;
+std::once_flag WeaverBufferPool::s_instanceFlag;
+
+/**
+ * \brief static function to get the singleton instance of WeaverBufferPool
+ * class
+ *
+ * \retval instance of WeaverBufferPool.
+ */
+WeaverBufferPool *WeaverBufferPool::getInstance() {
+  /* call_once c++11 api which executes the passed function ptr exactly once,
+   * even if called concurrently, from several threads
+   */
+  std::call_once(s_instanceFlag, &WeaverBufferPool::createInstance);
+  return s_instance;
+}
+
+/* Private function to create the instance of self class
+ * Same will be used for std::call_once
+ */
+void WeaverBufferPool::createInstance() {
+  LOG_D(TAG, "Entry");
+  s_instance = new WeaverBufferPool;
+  LOG_D(TAG, "Exit");
+}
+
+/* Maps the arena, locks it in memory & splits it into slots */
+WeaverBufferPool::WeaverBufferPool() {
+  size_t pageSize = sysconf(_SC_PAGESIZE);
+  size_t smallSize = WEAVER_POOL_SMALL_SLOT_SIZE * WEAVER_POOL_SMALL_SLOTS;
+  size_t size = smallSize + (WEAVER_POOL_SLOT_SIZE * WEAVER_POOL_SLOTS);
+  size = ((size + pageSize - 1) / pageSize) * pageSize;
+  void *arena = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (arena == MAP_FAILED) {
+    LOG_E(TAG, "Failed to map arena, using heap");
+    return;
+  }
+  if (mlock(arena, size) != 0) {
+    LOG_E(TAG, "Failed to lock arena, may be swapped");
+  }
+#ifdef MADV_DONTDUMP
+  madvise(arena, size, MADV_DONTDUMP);
+#endif
+  mArena = (uint8_t *)arena;
+  mArenaSize = size;
+  initSlots(mSmallSlots, mArena);
+  initSlots(mApduSlots, mArena + smallSize);
+}
+
+/* Splits the arena from base into the slots of the class */
+void WeaverBufferPool::initSlots(SlotClass &slots, uint8_t *base) {
+  slots.base = base;
+  slots.freeSlots.reserve(slots.slotCount);
+  for (size_t i = slots.slotCount; i > 0; i--) {
+    slots.freeSlots.push_back(base + ((i - 1) * slots.slotSize));
+  }
+}
+
+/**
+ * \brief Function to allocate a buffer
+ * \param[in]    size -         size of the buffer in bytes
+ *
+ * \retval This function return the buffer, never NULL
+ */
+void *WeaverBufferPool::allocate(size_t size) {
+  if (mArena != nullptr && size <= WEAVER_POOL_SLOT_SIZE) {
+    SlotClass &slots =
+        (size <= WEAVER_POOL_SMALL_SLOT_SIZE) ? mSmallSlots : mApduSlots;
+    std::lock_guard<std::mutex> lock(mLock);
+    if (!slots.freeSlots.empty()) {
+      uint8_t *slot = slots.freeSlots.back();
+      slots.freeSlots.pop_back();
+      return slot;
+    }
+    LOG_E(TAG, "Pool of (%zu) byte slots exhausted, using heap",
+          slots.slotSize);
+  } else if (mArena != nullptr) {
+    LOG_E(TAG, "No slot for (%zu) bytes, using heap", size);
+  }
+  return ::operator new(size);
+}
+
+/**
+ * \brief Function to zero & release a buffer
+ * \param[in]    ptr -          buffer returned by allocate
+ * \param[in]    size -         size passed to allocate
+ */
+void WeaverBufferPool::deallocate(void *ptr, size_t size) {
+  if (ptr == NULL) {
+    return;
+  }
+  SlotClass *slots = slotClassOf(ptr);
+  if (slots != NULL) {
+    wipe(ptr, slots->slotSize);
+    std::lock_guard<std::mutex> lock(mLock);
+    slots->freeSlots.push_back((uint8_t *)ptr);
+    return;
+  }
+  wipe(ptr, size);
+  ::operator delete(ptr);
+}
+
+/**
+ * \brief Function to zero memory, not optimized away by the compiler
+ * \param[in]    ptr -          memory to be zeroed
+ * \param[in]    size -         size of the memory in bytes
+ */
+void WeaverBufferPool::wipe(void *ptr, size_t size) {
+  memset(ptr, 0, size);
+  /* memory barrier so that the store isn't elided as dead */
+  __asm__ __volatile__("" : : "r"(ptr) : "memory");
+}
+
+/* Returns the class ptr is a slot of, NULL if not a slot of the arena */
+WeaverBufferPool::SlotClass *WeaverBufferPool::slotClassOf(const void *ptr) {
+  const uint8_t *p = (const uint8_t *)ptr;
+  if (mArena == nullptr) {
+    return NULL;
+  }
+  for (SlotClass *slots : {&mSmallSlots, &mApduSlots}) {
+    if (p >= slots->base &&
+        p < slots->base + (slots->slotSize * slots->slotCount)) {
+      return slots;
+    }
+  }
+  return NULL;
+}
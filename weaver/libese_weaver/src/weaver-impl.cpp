@@ -17,8 +17,9 @@
  ******************************************************************************/
 
 #define LOG_TAG "weaver-impl"
+#include <algorithm>
+#include <stdio.h>
 #include <weaver-impl.h>
-#include <weaver_parser-impl.h>
 #include <weaver_transport-impl.h>
 #include <weaver_utils.h>
 
@@ -55,16 +56,25 @@ void WeaverImpl::createInstance() {
 Status_Weaver WeaverImpl::Init() {
   LOG_D(TAG, "Entry");
   mTransport = WeaverTransportImpl::getInstance();
-  mParser = WeaverParserImpl::getInstance();
   RETURN_IF_NULL(mTransport, WEAVER_STATUS_FAILED, "Transport is NULL");
-  RETURN_IF_NULL(mParser, WEAVER_STATUS_FAILED, "Parser is NULL");
   std::vector<uint8_t> aid;
-  mParser->getAppletId(aid);
+  WeaverParser::getAppletId(aid);
   if (!mTransport->Init(aid)) {
     LOG_E(TAG, "Not able to Initilaize Transport Interface");
     LOG_D(TAG, "Exit : FAILED");
     return WEAVER_STATUS_FAILED;
   }
+  mTransport->RegisterEventCallback(this, transportEventFunc);
+  setTransportHold(0);
+  /* answer slot information of the previous run while warm up validates
+   * it against the applet */
+  mSnapshot.load();
+  /* Don't hold up service registration, connect in background */
+  if (!mWarmUp.valid()) {
+    auto done = std::make_shared<std::promise<void>>();
+    mWarmUp = done->get_future().share();
+    std::thread(&WeaverImpl::warmUp, this, done).detach();
+  }
   LOG_D(TAG, "Exit : SUCCESS");
   return WEAVER_STATUS_OK;
 }
@@ -78,45 +88,273 @@ Status_Weaver WeaverImpl::Init() {
  */
 Status_Weaver WeaverImpl::GetSlots(SlotInfo &slotInfo) {
   LOG_D(TAG, "Entry");
+  /* slot information doesn't change while applet is installed,
+   * answer from cache without waiting for the secure element */
+  if (getCachedSlots(slotInfo)) {
+    LOG_D(TAG, "Exit");
+    return WEAVER_STATUS_OK;
+  }
+  waitForWarmUp();
+  Status_Weaver status = fetchSlots(slotInfo);
+  LOG_D(TAG, "Exit");
+  return status;
+}
+
+/* Reads slot information from applet unless cached meanwhile */
+Status_Weaver WeaverImpl::fetchSlots(SlotInfo &slotInfo) {
+  WeaverSeAccess access(mSeQueue, SE_PRIORITY_HOUSEKEEPING);
+  /* slot information may have been read or announced on select while
+   * waiting. Snapshot is not enough, it is to be validated here */
+  refreshAppletCaps();
+  if (getCachedSlots(slotInfo, false)) {
+    settle();
+    return WEAVER_STATUS_OK;
+  }
+  mSessionTimer.kill();
   RETURN_IF_NULL(mTransport, WEAVER_STATUS_FAILED, "Transport is NULL");
-  RETURN_IF_NULL(mParser, WEAVER_STATUS_FAILED, "Parser is NULL");
+  Status_Weaver status = transactGetSlots(slotInfo);
+  if (!close()) {
+    // Channel Close Failed
+    LOG_E(TAG, "Failed to Close Channel");
+  }
+  return status;
+}
+
+/* Internal getSlot transaction on the current session, caches the result.
+ * Caller must own mSeQueue and close the session afterwards */
+Status_Weaver WeaverImpl::transactGetSlots(SlotInfo &slotInfo) {
   Status_Weaver status = WEAVER_STATUS_FAILED;
-  std::vector<uint8_t> getSlotCmd;
-  std::vector<uint8_t> resp;
+  WeaverSecureBuffer respBuffer;
+  std::span<uint8_t> resp = respBuffer.span();
   /* transport library don't require open applet
    * open will be done as part of send */
-  if (mParser->FrameGetSlotCmd(getSlotCmd) &&
-      mTransport->Send(getSlotCmd, resp)) {
+  if (mTransport->Send(WeaverParser::kGetSlotCmd, resp)) {
     status = WEAVER_STATUS_OK;
   } else {
     LOG_E(TAG, "Failed to perform getSlot Request");
   }
-  if (!close()) {
-    // Channel Close Failed
-    LOG_E(TAG, "Failed to Close Channel");
-  }
   if (status == WEAVER_STATUS_OK) {
-    status = mParser->ParseSlotInfo(resp, slotInfo);
+    status = WeaverParser::ParseSlotInfo(resp, slotInfo);
     LOG_D(TAG, "Total Slots (%u) ", slotInfo.slots);
+    if (status == WEAVER_STATUS_OK) {
+      {
+        std::lock_guard<std::mutex> lock(mSlotInfoLock);
+        mSlotInfo = slotInfo;
+        mIsSlotInfoCached = true;
+      }
+      refreshAppletCaps();
+      mSnapshot.update(slotInfo, mAppletCaps.version);
+    }
   } else {
     LOG_E(TAG, "Failed Parsing getSlot Response");
   }
-  LOG_D(TAG, "Exit");
   return status;
 }
 
-/* Internal close api for transport close */
-bool WeaverImpl::close() {
+/* Connects to the secure element and selects the applet off the critical
+ * path of the first request. Channel is then kept open for the idle period */
+void WeaverImpl::warmUp(std::shared_ptr<std::promise<void>> done) {
+  LOG_D(TAG, "Entry");
+  SlotInfo slotInfo;
+  if (fetchSlots(slotInfo) != WEAVER_STATUS_OK) {
+    LOG_E(TAG, "Warm up failed, first request will connect again");
+  }
+  done->set_value();
+  LOG_D(TAG, "Exit");
+}
+
+/* Waits, for a bounded time, until the start up warm up completes so that
+ * requests don't connect concurrently with it */
+void WeaverImpl::waitForWarmUp() {
+  /* each thread waits through its own copy of the shared state */
+  std::shared_future<void> warmUp = mWarmUp;
+  if (!warmUp.valid()) {
+    return;
+  }
+  if (warmUp.wait_for(std::chrono::milliseconds(WEAVER_WARM_UP_TIMEOUT)) !=
+      std::future_status::ready) {
+    LOG_E(TAG, "Warm up not completed in (%d) ms", WEAVER_WARM_UP_TIMEOUT);
+  }
+}
+
+/* Internal close api for transport close.
+ * Caller must own mSeQueue. Unless forced, the channel is kept open and
+ * the idle timer is armed so that back to back operations reuse the session.
+ * While other operations are queued the close is deferred to the last of
+ * them, so a burst of requests is served within one open channel */
+bool WeaverImpl::close(bool forceClose) {
   LOG_D(TAG, "Entry");
   bool status = true;
   RETURN_IF_NULL(mTransport, WEAVER_STATUS_FAILED, "Transport is NULL");
+  /* operation may have selected the applet again */
+  refreshAppletCaps();
+  mLastActivity = std::chrono::steady_clock::now();
+  if (!forceClose && mSeQueue.pending() > 0) {
+    LOG_D(TAG, "Operations queued, defer channel close");
+    mSessionTimer.kill();
+    mIsCloseDeferred = true;
+    LOG_D(TAG, "Exit");
+    return status;
+  }
+  mIsCloseDeferred = false;
+  uint32_t holdTime = sessionHoldTime();
+  if (!forceClose && holdTime > 0) {
+    LOG_D(TAG, "Keep channel open for (%u) ms", holdTime);
+    if (mSessionTimer.set(holdTime, this, sessionTimerFunc)) {
+      LOG_D(TAG, "Exit");
+      return status;
+    }
+    LOG_E(TAG, "Failed to set idle timer, closing channel");
+  }
+  mSessionTimer.kill();
   if (!mTransport->CloseApplet()) {
     status = false;
   }
+  /* prepare window, if any, is over */
+  setTransportHold(0);
   LOG_D(TAG, "Exit");
   return status;
 }
 
+/* Time in ms the session is to be kept open, the longer of the remaining
+ * idle period and the remaining prepare window. Caller must own mSeQueue */
+uint32_t WeaverImpl::sessionHoldTime() {
+  auto now = std::chrono::steady_clock::now();
+  auto holdUntil =
+      mLastActivity + std::chrono::milliseconds(mSessionIdleTimeout);
+  if (mPrepareUntil > holdUntil) {
+    holdUntil = mPrepareUntil;
+  }
+  if (holdUntil <= now) {
+    return 0;
+  }
+  return std::chrono::duration_cast<std::chrono::milliseconds>(holdUntil - now)
+      .count();
+}
+
+/* Idle close of the channel is owned by this class, the transport idle
+ * timeout is raised to cover the given hold and the idle period so that it
+ * only closes a channel this class failed to close. Caller must own mSeQueue */
+void WeaverImpl::setTransportHold(uint32_t holdMs) {
+  uint32_t minTimeout = std::max(holdMs, mSessionIdleTimeout);
+  mTransport->SetMinSessionTimeout(
+      (minTimeout > 0) ? (minTimeout + WEAVER_SESSION_HOLD_MARGIN) : 0);
+}
+
+/* Completes a close deferred by an earlier operation, for operations which
+ * release mSeQueue without using the channel. Caller must own mSeQueue */
+void WeaverImpl::settle() {
+  if (mIsCloseDeferred && !close()) {
+    LOG_E(TAG, "Failed to Close Channel");
+  }
+}
+
+/* Idle timer callback to close the channel once session is idle */
+void WeaverImpl::sessionTimerFunc(union sigval arg) {
+  WeaverImpl *self = (WeaverImpl *)arg.sival_ptr;
+  if (self == NULL) {
+    return;
+  }
+  WeaverSeAccess access(self->mSeQueue, SE_PRIORITY_HOUSEKEEPING);
+  /* An operation may have completed while this callback waited for the lock,
+   * in which case the session is not idle. Wait for the remaining time */
+  uint32_t holdTime = self->sessionHoldTime();
+  if (holdTime > 0) {
+    if (self->mIsCloseDeferred) {
+      self->settle();
+    } else {
+      self->mSessionTimer.set(holdTime, self, sessionTimerFunc);
+    }
+    return;
+  }
+  LOG_D(TAG, "Session idle, closing channel");
+  if (!self->close(true)) {
+    LOG_E(TAG, "Failed to Close Channel");
+  }
+}
+
+/* Transport event callback to invalidate cached applet state.
+ * Invoked from within transport operation, so must not wait for mSeQueue */
+void WeaverImpl::transportEventFunc(void *ctx, Transport_Event event) {
+  WeaverImpl *self = (WeaverImpl *)ctx;
+  if (self == NULL) {
+    return;
+  }
+  switch (event) {
+  case TRANSPORT_EVENT_APPLET_SELECTED:
+    self->mIsAppletCapsStale = true;
+    break;
+  case TRANSPORT_EVENT_SE_CONNECTED:
+  case TRANSPORT_EVENT_APPLET_UPDATE:
+    LOG_D(TAG, "Invalidate cached slot information, event (%d)", event);
+    {
+      std::lock_guard<std::mutex> lock(self->mSlotInfoLock);
+      self->mIsSlotInfoCached = false;
+    }
+    if (event == TRANSPORT_EVENT_APPLET_UPDATE) {
+      /* failure counters of the previous applet instance no longer apply */
+      self->mThrottleLedger.clear();
+      self->mSnapshot.invalidate();
+    }
+    break;
+  }
+}
+
+/* Provides cached slot information, or the snapshot if allowed, returns
+ * false if not cached */
+bool WeaverImpl::getCachedSlots(SlotInfo &slotInfo, bool allowSnapshot) {
+  std::lock_guard<std::mutex> lock(mSlotInfoLock);
+  if (!mIsSlotInfoCached) {
+    if (allowSnapshot && mSnapshot.get(slotInfo)) {
+      LOG_D(TAG, "Snapshot Total Slots (%u) ", slotInfo.slots);
+      return true;
+    }
+    return false;
+  }
+  slotInfo = mSlotInfo;
+  LOG_D(TAG, "Cached Total Slots (%u) ", slotInfo.slots);
+  return true;
+}
+
+/* Answers read of a throttled slot without secure element access,
+ * returns false if the slot is not throttled */
+bool WeaverImpl::isThrottled(uint32_t slotId, ReadRespInfo &readRespInfo) {
+  uint32_t timeout = mThrottleLedger.remaining(slotId);
+  if (timeout == 0) {
+    return false;
+  }
+  LOG_D(TAG, "Slot (%u) throttled for (%u) ms", slotId, timeout);
+  readRespInfo.timeout = timeout;
+  readRespInfo.value.clear();
+  return true;
+}
+
+/* Checks slotId against cached slot count, if available */
+bool WeaverImpl::isValidSlot(uint32_t slotId) {
+  std::lock_guard<std::mutex> lock(mSlotInfoLock);
+  if (mIsSlotInfoCached && slotId >= mSlotInfo.slots) {
+    LOG_E(TAG, "Invalid Slot (%u), Total Slots (%u)", slotId, mSlotInfo.slots);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * \brief Function to configure the applet session idle period
+ * \param[in]    timeoutMs -    idle period in ms after which the channel is
+ *                              closed, 0 closes it after every operation
+ */
+void WeaverImpl::setSessionIdleTimeout(uint32_t timeoutMs) {
+  LOG_D(TAG, "Entry");
+  WeaverSeAccess access(mSeQueue, SE_PRIORITY_HOUSEKEEPING);
+  mSessionIdleTimeout = timeoutMs;
+  if (mTransport != NULL) {
+    setTransportHold(sessionHoldTime());
+  }
+  settle();
+  LOG_D(TAG, "Exit");
+}
+
 /**
  * \brief Function to read value of specific key & slotId
  * \param[in]    slotId -       input slotId which's information to be read
@@ -126,35 +364,77 @@ bool WeaverImpl::close() {
  * \retval This function return Weaver_STATUS_OK (0) in case of success
  *         In case of failure returns other Status_Weaver errorcodes.
  */
-Status_Weaver WeaverImpl::Read(uint32_t slotId, const std::vector<uint8_t> &key,
+Status_Weaver WeaverImpl::Read(uint32_t slotId, std::span<const uint8_t> key,
                                ReadRespInfo &readRespInfo) {
   LOG_D(TAG, "Entry");
   RETURN_IF_NULL(mTransport, WEAVER_STATUS_FAILED, "Transport is NULL");
-  RETURN_IF_NULL(mParser, WEAVER_STATUS_FAILED, "Parser is NULL");
-  Status_Weaver status = WEAVER_STATUS_FAILED;
-  std::vector<uint8_t> readCmd;
-  std::vector<uint8_t> resp;
-  std::vector<uint8_t> aid;
-  /* transport library don't require open applet
-   * open will be done as part of send */
-  LOG_D(TAG, "Read from Slot (%u)", slotId);
-  if (mParser->FrameReadCmd(slotId, key, readCmd) &&
-      mTransport->Send(readCmd, resp)) {
-    status = WEAVER_STATUS_OK;
+  if (isThrottled(slotId, readRespInfo)) {
+    LOG_D(TAG, "Exit");
+    return WEAVER_STATUS_THROTTLE;
   }
-  if (!close()) {
-    // Channel Close Failed
-    LOG_E(TAG, "Failed to Close Channel");
+  waitForWarmUp();
+  /* identical read already in flight, wait for its result instead of
+   * sending another READ which would also count towards applet throttle */
+  bool isOwner = false;
+  std::shared_ptr<InFlightRead> inFlight;
+  {
+    std::lock_guard<std::mutex> lock(mInFlightLock);
+    inFlight = findInFlightRead(slotId, key);
+    if (inFlight == nullptr) {
+      inFlight = std::make_shared<InFlightRead>();
+      inFlight->slotId = slotId;
+      inFlight->key.assign(key.begin(), key.end());
+      inFlight->result = inFlight->promise.get_future().share();
+      mInFlightReads.push_back(inFlight);
+      isOwner = true;
+    }
   }
-  if (status == WEAVER_STATUS_OK) {
-    status = mParser->ParseReadInfo(resp, readRespInfo);
-  } else {
-    LOG_E(TAG, "Failed to perform Read Request for slot (%u)", slotId);
+  if (!isOwner) {
+    LOG_D(TAG, "Read from Slot (%u) coalesced with request in flight", slotId);
+    const WeaverOpResult &result = inFlight->result.get();
+    readRespInfo = result.readInfo;
+    LOG_D(TAG, "Exit");
+    return result.status;
   }
+  Status_Weaver status = WEAVER_STATUS_FAILED;
+  {
+    WeaverSeAccess access(mSeQueue, SE_PRIORITY_READ);
+    mSessionTimer.kill();
+    status = transactRead(slotId, key, readRespInfo);
+    if (!close()) {
+      // Channel Close Failed
+      LOG_E(TAG, "Failed to Close Channel");
+    }
+  }
+  /* later reads must reach the applet again, so unlist before publishing */
+  {
+    std::lock_guard<std::mutex> lock(mInFlightLock);
+    mInFlightReads.remove(inFlight);
+  }
+  inFlight->promise.set_value({status, readRespInfo});
   LOG_D(TAG, "Exit");
   return status;
 }
 
+/* Finds read in flight for same slot and key, caller must hold mInFlightLock */
+std::shared_ptr<WeaverImpl::InFlightRead>
+WeaverImpl::findInFlightRead(uint32_t slotId, std::span<const uint8_t> key) {
+  for (const auto &inFlight : mInFlightReads) {
+    if (inFlight->slotId != slotId || inFlight->key.size() != key.size()) {
+      continue;
+    }
+    /* constant time compare, key is secret */
+    uint8_t diff = 0;
+    for (size_t i = 0; i < key.size(); i++) {
+      diff |= inFlight->key[i] ^ key[i];
+    }
+    if (diff == 0) {
+      return inFlight;
+    }
+  }
+  return nullptr;
+}
+
 /**
  * \brief Function to write value to specific key & slotId
  * \param[in]    slotId -       input slotId where value to be write
@@ -165,28 +445,279 @@ Status_Weaver WeaverImpl::Read(uint32_t slotId, const std::vector<uint8_t> &key,
  *         In case of failure returns other Status_Weaver.
  */
 Status_Weaver WeaverImpl::Write(uint32_t slotId,
-                                const std::vector<uint8_t> &key,
-                                const std::vector<uint8_t> &value) {
+                                std::span<const uint8_t> key,
+                                std::span<const uint8_t> value) {
   LOG_D(TAG, "Entry");
+  waitForWarmUp();
+  WeaverSeAccess access(mSeQueue, SE_PRIORITY_WRITE);
+  mSessionTimer.kill();
   RETURN_IF_NULL(mTransport, WEAVER_STATUS_FAILED, "Transport is NULL");
-  RETURN_IF_NULL(mParser, WEAVER_STATUS_FAILED, "Parser is NULL");
+  Status_Weaver status = transactWrite(slotId, key, value);
+  if (!close()) {
+    LOG_E(TAG, "Failed to Close Channel");
+    // Channel Close Failed
+  }
+  LOG_D(TAG, "Exit");
+  return status;
+}
+
+/**
+ * \brief Function to perform multiple read/write operations in one session
+ * \param[in]    ops -          operations to be performed, in order
+ * \param[out]   results -      result of each operation, in the same order
+ *
+ * \retval This function return Weaver_STATUS_OK (0) if all operations were
+ *         processed, status of each operation is reported in results.
+ *         In case of failure returns other Status_Weaver.
+ */
+Status_Weaver WeaverImpl::Batch(const std::vector<WeaverOperation> &ops,
+                                std::vector<WeaverOpResult> &results) {
+  LOG_D(TAG, "Entry");
+  waitForWarmUp();
+  /* A batch with any write is scheduled as write, read-only as read */
+  SeAccess_Priority priority = SE_PRIORITY_READ;
+  for (auto &op : ops) {
+    if (op.type == WEAVER_OP_WRITE) {
+      priority = SE_PRIORITY_WRITE;
+      break;
+    }
+  }
+  WeaverSeAccess access(mSeQueue, priority);
+  mSessionTimer.kill();
+  RETURN_IF_NULL(mTransport, WEAVER_STATUS_FAILED, "Transport is NULL");
+  LOG_D(TAG, "Batch of (%zu) operations", ops.size());
+  refreshAppletCaps();
+  results.clear();
+  results.resize(ops.size());
+  /* operations left for the secure element after local checks */
+  std::vector<size_t> pending;
+  pending.reserve(ops.size());
+  for (size_t i = 0; i < ops.size(); i++) {
+    const WeaverOperation &op = ops[i];
+    WeaverOpResult &result = results[i];
+    result.readInfo.timeout = 0;
+    result.status = WEAVER_STATUS_FAILED;
+    if (op.type != WEAVER_OP_READ && op.type != WEAVER_OP_WRITE) {
+      LOG_E(TAG, "Unknown operation (%d)", op.type);
+    } else if (!isValidSlot(op.slotId)) {
+      LOG_E(TAG, "Invalid Slot (%u)", op.slotId);
+    } else if (op.type == WEAVER_OP_READ &&
+               isThrottled(op.slotId, result.readInfo)) {
+      result.status = WEAVER_STATUS_THROTTLE;
+    } else {
+      pending.push_back(i);
+    }
+  }
+  /* one applet batch command per chunk if supported, single commands
+   * otherwise or if applet rejects the batch command */
+  for (size_t done = 0; done < pending.size();) {
+    std::span<const size_t> chunk =
+        std::span<const size_t>(pending).subspan(done).first(
+            std::min(pending.size() - done, WeaverParser::BATCH_MAX_OPS));
+    done += chunk.size();
+    if (chunk.size() > 1 && mAppletCaps.batchIns != 0 &&
+        transactBatch(ops, chunk, results)) {
+      continue;
+    }
+    for (size_t i : chunk) {
+      const WeaverOperation &op = ops[i];
+      if (op.type == WEAVER_OP_READ) {
+        results[i].status = transactRead(op.slotId, op.key, results[i].readInfo);
+      } else {
+        results[i].status = transactWrite(op.slotId, op.key, op.value);
+      }
+    }
+  }
+  if (!close()) {
+    // Channel Close Failed
+    LOG_E(TAG, "Failed to Close Channel");
+  }
+  LOG_D(TAG, "Exit");
+  return WEAVER_STATUS_OK;
+}
+
+/* Internal batch transaction on the current session, returns false if the
+ * applet rejected the batch command and operations are to be sent singly.
+ * Once the applet accepted the batch, operations are never sent again.
+ * Caller must own mSeQueue and close the session afterwards */
+bool WeaverImpl::transactBatch(std::span<const WeaverOperation> ops,
+                               std::span<const size_t> indices,
+                               std::span<WeaverOpResult> results) {
+  /* pool slots are zeroed when released */
+  WeaverSecureBuffer cmdBuffer, respBuffer;
+  std::span<uint8_t> batchCmd = cmdBuffer.span();
+  std::span<uint8_t> resp = respBuffer.span();
+  LOG_D(TAG, "Batch command of (%zu) operations", indices.size());
+  if (!WeaverParser::FrameBatchCmd(mAppletCaps.batchIns, ops, indices,
+                                   batchCmd)) {
+    return false;
+  }
+  if (!mTransport->Send(batchCmd, resp)) {
+    LOG_E(TAG, "Failed to perform Batch Request");
+    for (size_t i : indices) {
+      results[i].status = WEAVER_STATUS_FAILED;
+    }
+    return true;
+  }
+  if (!WeaverParser::isSuccess(resp)) {
+    LOG_E(TAG, "Batch command rejected, falling back to single commands");
+    mAppletCaps.batchIns = 0;
+    return false;
+  }
+  /* applet executed the batch, operations without a valid record are
+   * reported failed rather than executed twice */
+  if (WeaverParser::ParseBatchResponse(resp, ops, indices, results) !=
+      WEAVER_STATUS_OK) {
+    LOG_E(TAG, "Malformed batch response");
+  }
+  for (size_t i : indices) {
+    if (ops[i].type == WEAVER_OP_READ) {
+      recordReadResult(ops[i].slotId, results[i].status, results[i].readInfo);
+    } else if (results[i].status == WEAVER_STATUS_OK) {
+      /* new key, failures of the previous one no longer apply */
+      mThrottleLedger.reset(ops[i].slotId);
+    }
+  }
+  return true;
+}
+
+/* Negotiates applet capabilities from the select response of the last
+ * opened channel, caches slot information if announced. Caller must own
+ * mSeQueue */
+void WeaverImpl::refreshAppletCaps() {
+  if (!mIsAppletCapsStale.exchange(false)) {
+    return;
+  }
+  std::vector<uint8_t> selectResponse;
+  mAppletCaps = {};
+  if (mTransport->GetSelectResponse(selectResponse)) {
+    WeaverParser::ParseSelectResponse(selectResponse, mAppletCaps);
+  }
+  LOG_D(TAG, "Applet version (0x%04X) batch INS (0x%02X)",
+        mAppletCaps.version, mAppletCaps.batchIns);
+  if (mAppletCaps.hasSlotInfo) {
+    {
+      std::lock_guard<std::mutex> lock(mSlotInfoLock);
+      mSlotInfo = mAppletCaps.slotInfo;
+      mIsSlotInfoCached = true;
+    }
+    mSnapshot.update(mAppletCaps.slotInfo, mAppletCaps.version);
+  } else {
+    mSnapshot.checkVersion(mAppletCaps.version);
+  }
+}
+
+/* Internal read transaction on the current session.
+ * Caller must own mSeQueue and close the session afterwards */
+Status_Weaver WeaverImpl::transactRead(uint32_t slotId,
+                                       std::span<const uint8_t> key,
+                                       ReadRespInfo &readRespInfo) {
   Status_Weaver status = WEAVER_STATUS_FAILED;
-  std::vector<uint8_t> readCmd;
-  std::vector<uint8_t> resp;
-  std::vector<uint8_t> aid;
+  /* pool slots are zeroed when released */
+  WeaverSecureBuffer cmdBuffer, respBuffer;
+  WeaverParser::ReadCmd readCmd =
+      cmdBuffer.span().first<WeaverParser::READ_CMD_SIZE>();
+  std::span<uint8_t> resp = respBuffer.span();
+  if (!isValidSlot(slotId)) {
+    return WEAVER_STATUS_FAILED;
+  }
+  if (isThrottled(slotId, readRespInfo)) {
+    return WEAVER_STATUS_THROTTLE;
+  }
   /* transport library don't require open applet
    * open will be done as part of send */
-  LOG_D(TAG, "Write to Slot (%u)", slotId);
-  if (mParser->FrameWriteCmd(slotId, key, value, readCmd) &&
+  LOG_D(TAG, "Read from Slot (%u)", slotId);
+  if (WeaverParser::FrameReadCmd(slotId, key, readCmd) &&
       mTransport->Send(readCmd, resp)) {
+    status = WeaverParser::ParseReadInfo(resp, readRespInfo);
+  } else {
+    LOG_E(TAG, "Failed to perform Read Request for slot (%u)", slotId);
+  }
+  recordReadResult(slotId, status, readRespInfo);
+  return status;
+}
+
+/* Updates throttle ledger with the read result. Applet doesn't report
+ * timeout, fill it from the throttling schedule */
+void WeaverImpl::recordReadResult(uint32_t slotId, Status_Weaver status,
+                                  ReadRespInfo &readRespInfo) {
+  switch (status) {
+  case WEAVER_STATUS_OK:
+    mThrottleLedger.reset(slotId);
+    break;
+  case WEAVER_STATUS_INCORRECT_KEY:
+    readRespInfo.timeout =
+        std::max(readRespInfo.timeout, mThrottleLedger.recordFailure(slotId));
+    break;
+  case WEAVER_STATUS_THROTTLE:
+    readRespInfo.timeout =
+        std::max(readRespInfo.timeout, mThrottleLedger.recordThrottle(slotId));
+    break;
+  default:
+    break;
+  }
+}
+
+/* Internal write transaction on the current session.
+ * Caller must own mSeQueue and close the session afterwards */
+Status_Weaver WeaverImpl::transactWrite(uint32_t slotId,
+                                        std::span<const uint8_t> key,
+                                        std::span<const uint8_t> value) {
+  Status_Weaver status = WEAVER_STATUS_FAILED;
+  /* pool slots are zeroed when released */
+  WeaverSecureBuffer cmdBuffer, respBuffer;
+  WeaverParser::WriteCmd writeCmd =
+      cmdBuffer.span().first<WeaverParser::WRITE_CMD_SIZE>();
+  std::span<uint8_t> resp = respBuffer.span();
+  if (!isValidSlot(slotId)) {
+    return WEAVER_STATUS_FAILED;
+  }
+  /* transport library don't require open applet
+   * open will be done as part of send */
+  LOG_D(TAG, "Write to Slot (%u)", slotId);
+  if (WeaverParser::FrameWriteCmd(slotId, key, value, writeCmd) &&
+      mTransport->Send(writeCmd, resp) && WeaverParser::isSuccess(resp)) {
     status = WEAVER_STATUS_OK;
+    /* new key, failures of the previous one no longer apply */
+    mThrottleLedger.reset(slotId);
+  } else {
+    LOG_E(TAG, "Failed to perform Write Request for slot (%u)", slotId);
+  }
+  return status;
+}
+
+/**
+ * \brief Function to connect & select applet ahead of an imminent read,
+ * the channel is then kept open for the given window
+ * \param[in]    windowMs -     period in ms to keep the channel open
+ *
+ * \retval This function return Weaver_STATUS_OK (0) in case of success
+ *         In case of failure returns other Status_Weaver.
+ */
+Status_Weaver WeaverImpl::Prepare(uint32_t windowMs) {
+  LOG_D(TAG, "Entry");
+  if (windowMs == 0) {
+    windowMs = WEAVER_PREPARE_WINDOW;
+  }
+  windowMs = std::min(windowMs, (uint32_t)WEAVER_PREPARE_MAX_WINDOW);
+  waitForWarmUp();
+  WeaverSeAccess access(mSeQueue, SE_PRIORITY_HOUSEKEEPING);
+  mSessionTimer.kill();
+  RETURN_IF_NULL(mTransport, WEAVER_STATUS_FAILED, "Transport is NULL");
+  /* transport arms its idle timeout on the transmit below */
+  setTransportHold(windowMs);
+  /* getSlot opens & selects the applet if channel is closed, and costs a
+   * single transmit otherwise */
+  SlotInfo slotInfo;
+  Status_Weaver status = transactGetSlots(slotInfo);
+  if (status == WEAVER_STATUS_OK) {
+    LOG_D(TAG, "Keep channel warm for (%u) ms", windowMs);
+    mPrepareUntil =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(windowMs);
   }
   if (!close()) {
-    LOG_E(TAG, "Failed to Close Channel");
     // Channel Close Failed
-  }
-  if (status != WEAVER_STATUS_OK || (!mParser->isSuccess(resp))) {
-    status = WEAVER_STATUS_FAILED;
+    LOG_E(TAG, "Failed to Close Channel");
   }
   LOG_D(TAG, "Exit");
   return status;
@@ -200,9 +731,34 @@ Status_Weaver WeaverImpl::Write(uint32_t slotId,
  */
 Status_Weaver WeaverImpl::DeInit() {
   LOG_D(TAG, "Entry");
+  WeaverSeAccess access(mSeQueue, SE_PRIORITY_HOUSEKEEPING);
+  mSessionTimer.kill();
   if (mTransport != NULL) {
     mTransport->DeInit();
   }
   LOG_D(TAG, "Exit");
   return WEAVER_STATUS_OK;
 }
+
+/**
+ * \brief Function to dump state & statistics of Weaver Interface
+ * \param[in]    fd -           file descriptor to write to
+ */
+void WeaverImpl::Dump(int fd) {
+  {
+    std::lock_guard<std::mutex> lock(mSlotInfoLock);
+    if (mIsSlotInfoCached) {
+      dprintf(fd, "Slots: %u, key size %u, value size %u\n",
+              mSlotInfo.slots, mSlotInfo.keySize, mSlotInfo.valueSize);
+    } else {
+      dprintf(fd, "Slots: not cached\n");
+    }
+  }
+  SlotInfo snapshot;
+  if (mSnapshot.get(snapshot)) {
+    dprintf(fd, "Snapshot: %u slots\n", snapshot.slots);
+  } else {
+    dprintf(fd, "Snapshot: none\n");
+  }
+  mSeQueue.dump(fd);
+}
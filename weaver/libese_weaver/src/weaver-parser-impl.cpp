@@ -17,44 +17,25 @@
  ******************************************************************************/
 
 #define LOG_TAG "weaver-parser-impl"
+#include <algorithm>
 #include <weaver_parser-impl.h>
 #include <weaver_utils.h>
 
-WeaverParserImpl *WeaverParserImpl::s_instance = NULL;
-std::once_flag WeaverParserImpl::s_instanceFlag;
-
-/* byte info for GP header of weaver commands */
-#define CLA 0x80
-#define INS_GET_SLOT 0x02
-#define INS_READ 0x06
-#define INS_WRITE 0x04
-#define P1 0x00
-#define P2 0x00
-#define LE_READ_CMD 0x11
-#define LE_GET_SLOT_CMD 0x04
+/* LE of weaver commands */
 #define LE_WRITE_CMD 0x00
+#define LE_MAX 0x00 // Short or extended LE of up to max response size
+#define SHORT_LC_MAX 255 // Max data size of short APDU
 
-/* Error code for weaver commands response */
-#define SUCCESS_SW1 0x90
-#define SUCCESS_SW2 0x00
-#define INVALID_SLOT_SW1 0x6A
-#define INVALID_SLOT_SW2 0x88
-#define INVALID_P1P2_SW1 0x6A
-#define INVALID_P1P2_SW2 0x86
-#define INVALID_LENGTH_SW1 0x67
-#define INVALID_LENGTH_SW2 0x00
-
-/* Supported Size by Applet */
-#define KEY_SIZE 16
-#define VALUE_SIZE 16
-#define RES_STATUS_SIZE 2
+/* For BER-TLV parsing of select response */
+#define TLV_CONSTRUCTED_MASK 0x20
+#define TLV_MULTI_BYTE_TAG_MASK 0x1F
+#define TLV_MORE_TAG_BYTES_MASK 0x80
+#define TLV_LONG_LEN_MASK 0x80
+#define TLV_LEN_1_BYTE 0x81
+#define TLV_LEN_2_BYTE 0x82
 
 /* For Applet Read Response TAG */
-#define INCORRECT_KEY_TAG 0x7F
-#define THROTTING_ENABLED_TAG 0x76
-#define READ_SUCCESS_TAG 0x00
-#define READ_ERR_CODE_INDEX 0 // Start index of above tag in read response
-#define READ_ERR_CODE_SIZE 1  // Size of above tag in read response
+#define READ_ERR_CODE_INDEX 0 // Start index of tag in read response
 
 #define SLOT_ID_INDEX 0 // Index of slotId in getSlot response
 
@@ -64,131 +45,307 @@ std::once_flag WeaverParserImpl::s_instanceFlag;
 #define BYTE2_MSB_POS 16
 #define BYTE1_MSB_POS 24
 
-/* Applet ID to be used for Weaver */
-const std::vector<uint8_t> kWeaverAID = {0xA0, 0x00, 0x00, 0x08, 0x44, 0x53, 0xF1, 0x27, 0x56,
-                                         0x18, 0x01, 0x00};
+/* Frames header & LC, short or extended as needed by lc,
+ * returns offset of the next byte to be framed */
+template <typename Profile>
+size_t WeaverParserImpl<Profile>::frameHeader(uint8_t ins, size_t lc,
+                                              std::span<uint8_t> request) {
+  size_t offset = 0;
+  request[offset++] = Profile::CLA;
+  request[offset++] = ins;
+  request[offset++] = Profile::P1;
+  request[offset++] = Profile::P2;
+  if (lc <= SHORT_LC_MAX) {
+    request[offset++] = lc; // LC
+  } else {
+    request[offset++] = 0x00; // extended LC
+    request[offset++] = SHIFT_MASK & (lc >> BYTE3_MSB_POS);
+    request[offset++] = SHIFT_MASK & lc;
+  }
+  return offset;
+}
 
-/**
- * \brief static function to get the singleton instance of WeaverParserImpl
- * class
- *
- * \retval instance of WeaverParserImpl.
- */
-WeaverParserImpl *WeaverParserImpl::getInstance() {
-  /* call_once c++11 api which executes the passed function ptr exactly once,
-   * even if called concurrently, from several threads
-   */
-  std::call_once(s_instanceFlag, &WeaverParserImpl::createInstance);
-  return s_instance;
+/* Frames slotId & key common to read, write & batch records,
+ * returns number of framed bytes */
+template <typename Profile>
+size_t WeaverParserImpl<Profile>::frameSlotKey(uint32_t slotId,
+                                               std::span<const uint8_t> key,
+                                               std::span<uint8_t> request) {
+  size_t offset = 0;
+  /* convert and insert 4 Byte integer slot id byte by byte */
+  request[offset++] = SHIFT_MASK & (slotId >> BYTE1_MSB_POS);
+  request[offset++] = SHIFT_MASK & (slotId >> BYTE2_MSB_POS);
+  request[offset++] = SHIFT_MASK & (slotId >> BYTE3_MSB_POS);
+  request[offset++] = SHIFT_MASK & slotId;
+  std::copy(key.begin(), key.end(), request.begin() + offset);
+  return offset + Profile::KEY_SIZE;
 }
 
-/* Private function to create the instance of self class
- * Same will be used for std::call_once
+/**
+ * \brief Function to Frame weaver applet request command for read
+ *
+ * \param[in]     slotId  - input slotId to be used in read request.
+ * \param[in]     key     - input key to be used in read request.
+ * \param[out]    request - buffer to frame read command into
+ *
+ * \retval This function return true in case of success
+ *         In case of failure returns false.
  */
-void WeaverParserImpl::createInstance() {
+template <typename Profile>
+bool WeaverParserImpl<Profile>::FrameReadCmd(uint32_t slotId,
+                                             std::span<const uint8_t> key,
+                                             ReadCmd request) {
   LOG_D(TAG, "Entry");
-  s_instance = new WeaverParserImpl;
+  if (key.size() != Profile::KEY_SIZE) {
+    LOG_E(TAG, "Exit Invalid key size (%zu)", key.size());
+    return false;
+  }
+  size_t offset = frameHeader(Profile::INS_READ,
+                              sizeof(uint32_t) + Profile::KEY_SIZE, request);
+  offset += frameSlotKey(slotId, key, request.subspan(offset));
+  request[offset] = Profile::VALUE_SIZE + READ_ERR_CODE_SIZE; // LE
   LOG_D(TAG, "Exit");
+  return true;
 }
 
 /**
- * \brief Function to Frame weaver applet request command for open
+ * \brief Function to Frame weaver applet request command for write
  *
- * \param[out]    request - framed open command as vector
+ * \param[in]     slotId  - input slotId to be used in write request.
+ * \param[in]     key     - input key to be used in write request.
+ * \param[in]     value   - input value to be used in write request.
+ * \param[out]    request - buffer to frame write command into
  *
  * \retval This function return true in case of success
  *         In case of failure returns false.
  */
-bool WeaverParserImpl::FrameOpenCmd(std::vector<uint8_t> &request) {
+template <typename Profile>
+bool WeaverParserImpl<Profile>::FrameWriteCmd(uint32_t slotId,
+                                              std::span<const uint8_t> key,
+                                              std::span<const uint8_t> value,
+                                              WriteCmd request) {
   LOG_D(TAG, "Entry");
-  UNUSED(request);
+  if (key.size() != Profile::KEY_SIZE ||
+      value.size() != Profile::VALUE_SIZE) {
+    LOG_E(TAG, "Exit Invalid key (%zu) or value (%zu) size", key.size(),
+          value.size());
+    return false;
+  }
+  size_t offset = frameHeader(
+      Profile::INS_WRITE,
+      sizeof(uint32_t) + Profile::KEY_SIZE + Profile::VALUE_SIZE, request);
+  offset += frameSlotKey(slotId, key, request.subspan(offset));
+  std::copy(value.begin(), value.end(), request.begin() + offset);
+  request[offset + Profile::VALUE_SIZE] = LE_WRITE_CMD;
   LOG_D(TAG, "Exit");
   return true;
 }
 
 /**
- * \brief Function to Frame weaver applet request command for getSlots
+ * \brief Function to Frame applet batch command, extended length APDU is
+ * used if records don't fit a short APDU
  *
- * \param[out]    request - framed getslots command as vector
+ * \param[in]     ins     - INS of the batch command, see ParseSelectResponse
+ * \param[in]     ops     - operations to pick the records from.
+ * \param[in]     indices - indices of the operations to be framed, in order,
+ *                         at most BATCH_MAX_OPS.
+ * \param[in,out] request - buffer to frame batch command into, narrowed to
+ *                         the framed command
  *
  * \retval This function return true in case of success
  *         In case of failure returns false.
  */
-bool WeaverParserImpl::FrameGetSlotCmd(std::vector<uint8_t> &request) {
+template <typename Profile>
+bool WeaverParserImpl<Profile>::FrameBatchCmd(
+    uint8_t ins, std::span<const WeaverOperation> ops,
+    std::span<const size_t> indices, std::span<uint8_t> &request) {
   LOG_D(TAG, "Entry");
-  request.clear();
-  request.push_back(CLA);
-  request.push_back(INS_GET_SLOT);
-  request.push_back(P1);
-  request.push_back(P2);
-  request.push_back(LE_GET_SLOT_CMD);
+  if (indices.empty() || indices.size() > BATCH_MAX_OPS) {
+    LOG_E(TAG, "Exit Invalid batch of (%zu) operations", indices.size());
+    return false;
+  }
+  size_t lc = 0;
+  for (size_t index : indices) {
+    const WeaverOperation &op = ops[index];
+    if (op.key.size() != Profile::KEY_SIZE ||
+        (op.type == WEAVER_OP_WRITE && op.value.size() != Profile::VALUE_SIZE)) {
+      LOG_E(TAG, "Exit Invalid key or value size of operation (%zu)", index);
+      return false;
+    }
+    lc += 1 + sizeof(uint32_t) + Profile::KEY_SIZE;
+    lc += (op.type == WEAVER_OP_WRITE) ? Profile::VALUE_SIZE : 0;
+  }
+  size_t size = (lc <= SHORT_LC_MAX) ? (HEADER_SIZE + 1 + lc + 1)
+                                     : (EXT_HEADER_SIZE + lc + EXT_LE_SIZE);
+  if (size > request.size()) {
+    LOG_E(TAG, "Exit Command (%zu) exceeds request buffer", size);
+    return false;
+  }
+  size_t offset = frameHeader(ins, lc, request);
+  for (size_t index : indices) {
+    const WeaverOperation &op = ops[index];
+    request[offset++] =
+        (op.type == WEAVER_OP_WRITE) ? Profile::INS_WRITE : Profile::INS_READ;
+    offset += frameSlotKey(op.slotId, op.key, request.subspan(offset));
+    if (op.type == WEAVER_OP_WRITE) {
+      std::copy(op.value.begin(), op.value.end(), request.begin() + offset);
+      offset += Profile::VALUE_SIZE;
+    }
+  }
+  /* extended LC requires extended LE */
+  request[offset++] = LE_MAX;
+  if (lc > SHORT_LC_MAX) {
+    request[offset++] = LE_MAX;
+  }
+  request = request.first(offset);
   LOG_D(TAG, "Exit");
   return true;
 }
 
+/* Finds a single byte tag in BER-TLV data, searching constructed tags */
+template <typename Profile>
+bool WeaverParserImpl<Profile>::findTag(std::span<const uint8_t> data,
+                                        uint8_t tag,
+                                        std::span<const uint8_t> &value) {
+  size_t offset = 0;
+  while (offset < data.size()) {
+    uint8_t first = data[offset++];
+    bool isSingleByte =
+        (first & TLV_MULTI_BYTE_TAG_MASK) != TLV_MULTI_BYTE_TAG_MASK;
+    if (!isSingleByte) {
+      while (offset < data.size() && (data[offset] & TLV_MORE_TAG_BYTES_MASK)) {
+        offset++;
+      }
+      offset++;
+    }
+    if (offset >= data.size()) {
+      return false;
+    }
+    size_t len = data[offset++];
+    if (len == TLV_LEN_1_BYTE && offset + 1 <= data.size()) {
+      len = data[offset++];
+    } else if (len == TLV_LEN_2_BYTE && offset + 2 <= data.size()) {
+      len = (data[offset] << BYTE3_MSB_POS) | data[offset + 1];
+      offset += 2;
+    } else if (len & TLV_LONG_LEN_MASK) {
+      return false;
+    }
+    if (len > data.size() - offset) {
+      return false;
+    }
+    std::span<const uint8_t> tlvValue = data.subspan(offset, len);
+    if (isSingleByte && first == tag) {
+      value = tlvValue;
+      return true;
+    }
+    if ((first & TLV_CONSTRUCTED_MASK) && findTag(tlvValue, tag, value)) {
+      return true;
+    }
+    offset += len;
+  }
+  return false;
+}
+
 /**
- * \brief Function to Frame weaver applet request command for read
+ * \brief Function to Parse select response for applet capabilities
  *
- * \param[in]     slotId  - input slotId to be used in read request.
- * \param[in]     key     - input key to be used in read request.
- * \param[out]    request - framed read command as vector
+ * \param[in]     response  - select response of the applet.
+ * \param[out]    caps      - capabilities announced by the applet, none
+ * if not announced.
  *
  * \retval This function return true in case of success
  *         In case of failure returns false.
  */
-bool WeaverParserImpl::FrameReadCmd(uint32_t slotId,
-                                    const std::vector<uint8_t> &key,
-                                    std::vector<uint8_t> &request) {
+template <typename Profile>
+bool WeaverParserImpl<Profile>::ParseSelectResponse(
+    std::span<const uint8_t> response, AppletCaps &caps) {
   LOG_D(TAG, "Entry");
-  request.clear();
-  request.push_back(CLA);
-  request.push_back(INS_READ);
-  request.push_back(P1);
-  request.push_back(P2);
-  request.push_back(sizeof(uint32_t) + key.size()); // LC
-  /* convert and insert 4 Byte integer slot id as byte by byte to vector */
-  request.push_back(SHIFT_MASK & (slotId >> BYTE1_MSB_POS));
-  request.push_back(SHIFT_MASK & (slotId >> BYTE2_MSB_POS));
-  request.push_back(SHIFT_MASK & (slotId >> BYTE3_MSB_POS));
-  request.push_back(SHIFT_MASK & slotId);
-  request.insert(std::end(request), std::begin(key), std::end(key));
-  request.push_back(LE_READ_CMD);
-  LOG_D(TAG, "Exit");
+  caps = {};
+  if (!isSuccess(response)) {
+    LOG_E(TAG, "Exit Select failed");
+    return false;
+  }
+  std::span<const uint8_t> data =
+      response.first(response.size() - RES_STATUS_SIZE);
+  std::span<const uint8_t> value;
+  /* older applets don't announce anything, single commands are used */
+  if (findTag(data, Profile::VERSION_TAG, value) && value.size() == 2) {
+    caps.version = (value[0] << BYTE3_MSB_POS) | value[1];
+  }
+  if (findTag(data, Profile::BATCH_INS_TAG, value) && value.size() == 1) {
+    caps.batchIns = value[0];
+  }
+  std::span<const uint8_t> keySize, valueSize;
+  if (findTag(data, Profile::SLOT_COUNT_TAG, value) &&
+      value.size() == sizeof(uint32_t) &&
+      findTag(data, Profile::KEY_SIZE_TAG, keySize) && keySize.size() == 1 &&
+      findTag(data, Profile::VALUE_SIZE_TAG, valueSize) &&
+      valueSize.size() == 1) {
+    /* commands are framed for the sizes of the profile, an applet of other
+     * sizes can't be served */
+    if (keySize[0] != Profile::KEY_SIZE || valueSize[0] != Profile::VALUE_SIZE) {
+      LOG_E(TAG, "Applet sizes (%u/%u) don't match profile", keySize[0],
+            valueSize[0]);
+    } else {
+      caps.slotInfo.slots = (value[0] << BYTE1_MSB_POS) |
+                            (value[1] << BYTE2_MSB_POS) |
+                            (value[2] << BYTE3_MSB_POS) | value[3];
+      caps.slotInfo.keySize = Profile::KEY_SIZE;
+      caps.slotInfo.valueSize = Profile::VALUE_SIZE;
+      caps.hasSlotInfo = true;
+    }
+  }
+  LOG_D(TAG, "Exit Version (0x%04X) Batch INS (0x%02X) Slots (%u)",
+        caps.version, caps.batchIns, caps.slotInfo.slots);
   return true;
 }
 
 /**
- * \brief Function to Frame weaver applet request command for write
+ * \brief Function to Parse applet batch response
  *
- * \param[in]     slotId  - input slotId to be used in write request.
- * \param[in]     key     - input key to be used in write request.
- * \param[in]     value   - input value to be used in write request.
- * \param[out]    request - framed write command as vector
+ * \param[in]     response  - response from applet.
+ * \param[in]     ops       - operations the command was framed from.
+ * \param[in]     indices   - indices of the framed operations, in order.
+ * \param[out]    results   - result of each framed operation, at same index
+ * as the operation.
  *
- * \retval This function return true in case of success
- *         In case of failure returns false.
+ * \retval This function return Weaver_STATUS_OK (0) if applet processed the
+ *         batch, status of each operation is reported in results.
+ *         In case of failure returns other Status_Weaver, operations without
+ *         a valid record are then reported failed in results.
  */
-bool WeaverParserImpl::FrameWriteCmd(uint32_t slotId,
-                                     const std::vector<uint8_t> &key,
-                                     const std::vector<uint8_t> &value,
-                                     std::vector<uint8_t> &request) {
+template <typename Profile>
+Status_Weaver WeaverParserImpl<Profile>::ParseBatchResponse(
+    std::span<const uint8_t> response, std::span<const WeaverOperation> ops,
+    std::span<const size_t> indices, std::span<WeaverOpResult> results) {
   LOG_D(TAG, "Entry");
-  request.clear();
-  request.push_back(CLA);
-  request.push_back(INS_WRITE);
-  request.push_back(P1);
-  request.push_back(P2);
-  request.push_back(sizeof(uint32_t) + key.size() + value.size()); // LC
-  /* convert and insert 4 Byte integer slot id as byte by byte to vector */
-  request.push_back(SHIFT_MASK & (slotId >> BYTE1_MSB_POS));
-  request.push_back(SHIFT_MASK & (slotId >> BYTE2_MSB_POS));
-  request.push_back(SHIFT_MASK & (slotId >> BYTE3_MSB_POS));
-  request.push_back(SHIFT_MASK & slotId);
-  request.insert(std::end(request), std::begin(key), std::end(key));
-  request.insert(std::end(request), std::begin(value), std::end(value));
-  request.push_back(LE_WRITE_CMD);
+  for (size_t index : indices) {
+    results[index].status = WEAVER_STATUS_FAILED;
+  }
+  if (!isSuccess(response)) {
+    LOG_E(TAG, "Exit Batch rejected");
+    return WEAVER_STATUS_FAILED;
+  }
+  std::span<const uint8_t> data =
+      response.first(response.size() - RES_STATUS_SIZE);
+  size_t offset = 0;
+  for (size_t index : indices) {
+    if (offset >= data.size() || data[offset] > data.size() - offset - 1) {
+      LOG_E(TAG, "Exit Truncated batch response");
+      return WEAVER_STATUS_FAILED;
+    }
+    std::span<const uint8_t> record = data.subspan(offset + 1, data[offset]);
+    offset += 1 + record.size();
+    WeaverOpResult &result = results[index];
+    if (ops[index].type == WEAVER_OP_WRITE) {
+      result.status =
+          isSuccess(record) ? WEAVER_STATUS_OK : WEAVER_STATUS_FAILED;
+    } else {
+      result.status = ParseReadInfo(record, result.readInfo);
+    }
+  }
   LOG_D(TAG, "Exit");
-  return true;
+  return WEAVER_STATUS_OK;
 }
 
 /**
@@ -201,20 +358,26 @@ bool WeaverParserImpl::FrameWriteCmd(uint32_t slotId,
  * \retval This function return true in case of success
  *         In case of failure returns false.
  */
-Status_Weaver WeaverParserImpl::ParseSlotInfo(std::vector<uint8_t> response,
-                                              SlotInfo &slotInfo) {
+template <typename Profile>
+Status_Weaver
+WeaverParserImpl<Profile>::ParseSlotInfo(std::span<const uint8_t> response,
+                                         SlotInfo &slotInfo) {
   LOG_D(TAG, "Entry");
   Status_Weaver status = WEAVER_STATUS_FAILED;
   slotInfo.slots = 0;
+  if (response.size() < (SLOT_ID_INDEX + sizeof(uint32_t) + RES_STATUS_SIZE)) {
+    LOG_E(TAG, "Exit Invalid Response Size");
+    return status;
+  }
   if (isSuccess(response)) {
     /* Read 4 bytes for number of slot as integer. */
-    uint32_t slots = response.at(SLOT_ID_INDEX) << BYTE1_MSB_POS;
-    slots |= response.at(SLOT_ID_INDEX + 1) << BYTE2_MSB_POS;
-    slots |= response.at(SLOT_ID_INDEX + 2) << BYTE3_MSB_POS;
-    slots |= response.at(SLOT_ID_INDEX + 3);
+    uint32_t slots = response[SLOT_ID_INDEX] << BYTE1_MSB_POS;
+    slots |= response[SLOT_ID_INDEX + 1] << BYTE2_MSB_POS;
+    slots |= response[SLOT_ID_INDEX + 2] << BYTE3_MSB_POS;
+    slots |= response[SLOT_ID_INDEX + 3];
     slotInfo.slots = slots;
-    slotInfo.keySize = KEY_SIZE;
-    slotInfo.valueSize = VALUE_SIZE;
+    slotInfo.keySize = Profile::KEY_SIZE;
+    slotInfo.valueSize = Profile::VALUE_SIZE;
     status = WEAVER_STATUS_OK;
   }
   LOG_D(TAG, "Exit");
@@ -231,35 +394,35 @@ Status_Weaver WeaverParserImpl::ParseSlotInfo(std::vector<uint8_t> response,
  * \retval This function return true in case of success
  *         In case of failure returns false.
  */
-Status_Weaver WeaverParserImpl::ParseReadInfo(std::vector<uint8_t> response,
-                                              ReadRespInfo &readInfo) {
+template <typename Profile>
+Status_Weaver
+WeaverParserImpl<Profile>::ParseReadInfo(std::span<const uint8_t> response,
+                                         ReadRespInfo &readInfo) {
   LOG_D(TAG, "Entry");
   Status_Weaver status = WEAVER_STATUS_FAILED;
-  if (response.size() < RES_STATUS_SIZE) {
+  if (response.size() < RES_STATUS_SIZE + READ_ERR_CODE_SIZE) {
     LOG_E(TAG, "Exit Invalid Response Size");
     return status;
   }
   if (isSuccess(response)) {
-    readInfo.timeout = 0; // Applet not supporting timeout value
-    switch (response.at(READ_ERR_CODE_INDEX)) {
-    case INCORRECT_KEY_TAG:
+    readInfo.timeout = 0; // Applet not supporting timeout value, see ledger
+    switch (response[READ_ERR_CODE_INDEX]) {
+    case Profile::INCORRECT_KEY_TAG:
       LOG_E(TAG, "INCORRECT_KEY");
       status = WEAVER_STATUS_INCORRECT_KEY;
       readInfo.value.resize(0);
       break;
-    case THROTTING_ENABLED_TAG:
+    case Profile::THROTTING_ENABLED_TAG:
       LOG_E(TAG, "THROTTING_ENABLED");
       status = WEAVER_STATUS_THROTTLE;
       readInfo.value.resize(0);
       break;
-    case READ_SUCCESS_TAG:
-      if ((VALUE_SIZE + READ_ERR_CODE_SIZE + RES_STATUS_SIZE) ==
+    case Profile::READ_SUCCESS_TAG:
+      if ((Profile::VALUE_SIZE + READ_ERR_CODE_SIZE + RES_STATUS_SIZE) ==
           response.size()) {
         LOG_D(TAG, "SUCCESS");
-        readInfo.value.clear();
-        readInfo.value.insert(std::end(readInfo.value),
-                              std::begin(response) + READ_ERR_CODE_SIZE,
-                              std::end(response) - RES_STATUS_SIZE);
+        readInfo.value.assign(response.begin() + READ_ERR_CODE_SIZE,
+                              response.end() - RES_STATUS_SIZE);
         status = WEAVER_STATUS_OK;
       } else {
         LOG_E(TAG, "Invalid Response");
@@ -281,7 +444,8 @@ Status_Weaver WeaverParserImpl::ParseReadInfo(std::vector<uint8_t> response,
  * \retval This function return true if response code from applet is success
  *         and false in other cases.
  */
-bool WeaverParserImpl::isSuccess(std::vector<uint8_t> response) {
+template <typename Profile>
+bool WeaverParserImpl<Profile>::isSuccess(std::span<const uint8_t> response) {
   return (checkStatus(response) == APP_SUCCESS) ? true : false;
 }
 
@@ -292,29 +456,30 @@ bool WeaverParserImpl::isSuccess(std::vector<uint8_t> response) {
  *
  * \retval This function return errorcode from APP_ERR_CODE type
  */
-WeaverParserImpl::APP_ERR_CODE
-WeaverParserImpl::checkStatus(std::vector<uint8_t> response) {
+template <typename Profile>
+typename WeaverParserImpl<Profile>::APP_ERR_CODE
+WeaverParserImpl<Profile>::checkStatus(std::span<const uint8_t> response) {
   LOG_D(TAG, "Entry");
   APP_ERR_CODE status = APP_FAILED;
   if (RES_STATUS_SIZE > response.size()) {
     LOG_E(TAG, "Response is too short");
     status = APP_FAILED;
-  } else if (response.at(response.size() - 2) == SUCCESS_SW1 &&
-             response.at(response.size() - 1) == SUCCESS_SW2) {
+  } else if (response[response.size() - 2] == Profile::SUCCESS_SW1 &&
+             response[response.size() - 1] == Profile::SUCCESS_SW2) {
     LOG_D(TAG, "SUCCESS");
     status = APP_SUCCESS;
-  } else if (response.at(response.size() - 2) == INVALID_SLOT_SW1 &&
-             response.at(response.size() - 1) == INVALID_SLOT_SW2) {
+  } else if (response[response.size() - 2] == Profile::INVALID_SLOT_SW1 &&
+             response[response.size() - 1] == Profile::INVALID_SLOT_SW2) {
     // Invalid Slot ID
     LOG_E(TAG, "Invalid Slot");
     status = APP_INVALID_SLOT;
-  } else if (response.at(response.size() - 2) == INVALID_P1P2_SW1 &&
-             response.at(response.size() - 1) == INVALID_P1P2_SW2) {
+  } else if (response[response.size() - 2] == Profile::INVALID_P1P2_SW1 &&
+             response[response.size() - 1] == Profile::INVALID_P1P2_SW2) {
     // Invalid P1/P2
     LOG_E(TAG, "Invalid P1/P2");
     status = APP_INVALID_P1_P2;
-  } else if (response.at(response.size() - 2) == INVALID_LENGTH_SW1 &&
-             response.at(response.size() - 1) == INVALID_LENGTH_SW2) {
+  } else if (response[response.size() - 2] == Profile::INVALID_LENGTH_SW1 &&
+             response[response.size() - 1] == Profile::INVALID_LENGTH_SW2) {
     // Invalid Length
     LOG_E(TAG, "Invalid Length");
     status = APP_INVALID_LEN;
@@ -331,13 +496,15 @@ WeaverParserImpl::checkStatus(std::vector<uint8_t> response) {
  * \retval This function return true in case of success
  *         In case of failure returns false.
  */
-bool WeaverParserImpl::getAppletId(std::vector<uint8_t> &aid) {
+template <typename Profile>
+bool WeaverParserImpl<Profile>::getAppletId(std::vector<uint8_t> &aid) {
   LOG_D(TAG, "Entry");
-  bool status = false;
-  if (kWeaverAID.size() > 0) {
-    aid = kWeaverAID;
-    status = true;
-  }
+  static_assert(Profile::AID.size() > 0, "Applet ID is empty");
+  aid.assign(Profile::AID.begin(), Profile::AID.end());
   LOG_D(TAG, "Exit");
-  return status;
+  return true;
 }
+
+/* Parsers of the known applet variants */
+template class WeaverParserImpl<WeaverAppletProfile>;
+template class WeaverParserImpl<WeaverAppletProfileValue32>;
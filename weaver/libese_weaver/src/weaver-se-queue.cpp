@@ -0,0 +1,152 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "weaver-se-queue"
+#include <inttypes.h>
+#include <stdio.h>
+#include <weaver_se_queue.h>
+#include <weaver_utils.h>
+
+/* Upper bound in ms of each queue wait time histogram bucket */
+static const uint64_t kWaitBucketsMs[SE_QUEUE_WAIT_BUCKETS] = {
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 5000, UINT64_MAX};
+
+static const char *kPriorityNames[SE_PRIORITY_MAX] = {"read", "write",
+                                                       "housekeeping"};
+
+/**
+ * \brief Function to wait until caller owns the secure element
+ * \param[in]    priority -     priority class of the caller
+ */
+void WeaverSeQueue::acquire(SeAccess_Priority priority) {
+  std::unique_lock<std::mutex> lock(mLock);
+  uint64_t ticket = mNextTicket++;
+  auto arrival = std::chrono::steady_clock::now();
+  mWaiters.push_back({ticket, priority, arrival});
+  if (mOwnerTicket == 0) {
+    grantNext();
+  }
+  mCond.wait(lock, [this, ticket] { return ticket == mOwnerTicket; });
+  auto wait = std::chrono::steady_clock::now() - arrival;
+  recordWait(priority,
+             std::chrono::duration_cast<std::chrono::microseconds>(wait).count());
+}
+
+/**
+ * \brief Function to hand over the secure element to next waiting caller
+ */
+void WeaverSeQueue::release() {
+  std::lock_guard<std::mutex> lock(mLock);
+  mOwnerTicket = 0;
+  if (!mWaiters.empty()) {
+    grantNext();
+  }
+}
+
+/**
+ * \brief Function to get number of callers waiting for the secure element
+ *
+ * \retval This function return number of waiting callers
+ */
+size_t WeaverSeQueue::pending() {
+  std::lock_guard<std::mutex> lock(mLock);
+  return mWaiters.size();
+}
+
+/* Grants access to the waiter with best aged priority, caller holds mLock.
+ * Each SE_QUEUE_AGING_STEP of waiting promotes a waiter by one class,
+ * ties are resolved in order of arrival */
+void WeaverSeQueue::grantNext() {
+  auto now = std::chrono::steady_clock::now();
+  auto best = mWaiters.end();
+  int64_t bestPriority = SE_PRIORITY_MAX;
+  for (auto it = mWaiters.begin(); it != mWaiters.end(); it++) {
+    int64_t waitMs =
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - it->arrival)
+            .count();
+    int64_t priority = (int64_t)it->priority - (waitMs / SE_QUEUE_AGING_STEP);
+    if (priority < 0) {
+      priority = 0;
+    }
+    if (priority < bestPriority) {
+      bestPriority = priority;
+      best = it;
+    }
+  }
+  if (best == mWaiters.end()) {
+    return;
+  }
+  mOwnerTicket = best->ticket;
+  mWaiters.erase(best);
+  mCond.notify_all();
+}
+
+/* Records queue wait time of a granted caller, caller holds mLock */
+void WeaverSeQueue::recordWait(SeAccess_Priority priority, uint64_t waitUs) {
+  WeaverSeQueueStats &stats = mStats[priority];
+  stats.count++;
+  stats.totalWaitUs += waitUs;
+  if (waitUs > stats.maxWaitUs) {
+    stats.maxWaitUs = waitUs;
+  }
+  int i = 0;
+  while (i < SE_QUEUE_WAIT_BUCKETS - 1 && waitUs > kWaitBucketsMs[i] * 1000) {
+    i++;
+  }
+  stats.histogram[i]++;
+}
+
+/**
+ * \brief Function to get queue wait statistics of a priority class
+ * \param[in]    priority -     priority class
+ * \param[out]   stats -        queue wait statistics of the class
+ */
+void WeaverSeQueue::getStats(SeAccess_Priority priority,
+                             WeaverSeQueueStats &stats) {
+  std::lock_guard<std::mutex> lock(mLock);
+  stats = mStats[priority];
+}
+
+/**
+ * \brief Function to dump queue wait statistics of all priority classes
+ * \param[in]    fd -           file descriptor to write to
+ */
+void WeaverSeQueue::dump(int fd) {
+  std::lock_guard<std::mutex> lock(mLock);
+  dprintf(fd, "SE access queue: %zu waiting\n", mWaiters.size());
+  for (int p = 0; p < SE_PRIORITY_MAX; p++) {
+    const WeaverSeQueueStats &stats = mStats[p];
+    uint64_t avgUs = (stats.count > 0) ? (stats.totalWaitUs / stats.count) : 0;
+    /* p50/p99 as upper bound of the bucket holding that percentile */
+    uint64_t p50 = 0, p99 = 0, seen = 0;
+    for (int i = 0; i < SE_QUEUE_WAIT_BUCKETS && stats.count > 0; i++) {
+      seen += stats.histogram[i];
+      if (p50 == 0 && seen * 100 >= stats.count * 50) {
+        p50 = kWaitBucketsMs[i];
+      }
+      if (p99 == 0 && seen * 100 >= stats.count * 99) {
+        p99 = kWaitBucketsMs[i];
+        break;
+      }
+    }
+    dprintf(fd,
+            "  %-12s count %" PRIu64 " avg %" PRIu64 " us max %" PRIu64
+            " us p50 <= %" PRIu64 " ms p99 <= %" PRIu64 " ms\n",
+            kPriorityNames[p], stats.count, avgUs, stats.maxWaitUs, p50, p99);
+  }
+}
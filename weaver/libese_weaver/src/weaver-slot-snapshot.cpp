@@ -0,0 +1,181 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "weaver-slot-snapshot"
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <weaver_slot_snapshot.h>
+#include <weaver_utils.h>
+
+/* Identifies the snapshot file, "WVSS" */
+#define WEAVER_SNAPSHOT_MAGIC (0x57565353)
+/* Temporary file the record is written to before being renamed */
+#define WEAVER_SNAPSHOT_TMP_PATH WEAVER_SNAPSHOT_PATH ".tmp"
+
+/* FNV-1a parameters for checksum */
+#define FNV_OFFSET_BASIS (0x811C9DC5)
+#define FNV_PRIME (0x01000193)
+
+/**
+ * \brief Function to load the snapshot from file
+ *
+ * \retval This function return true if a valid snapshot was loaded
+ *         In case of missing or corrupt file returns false.
+ */
+bool WeaverSlotSnapshot::load() {
+  std::lock_guard<std::mutex> lock(mLock);
+  mIsUsable = false;
+  int fd = TEMP_FAILURE_RETRY(open(WEAVER_SNAPSHOT_PATH, O_RDONLY | O_CLOEXEC));
+  if (fd < 0) {
+    LOG_D(TAG, "No snapshot (%s)", strerror(errno));
+    return false;
+  }
+  Record record;
+  ssize_t len = TEMP_FAILURE_RETRY(read(fd, &record, sizeof(record)));
+  close(fd);
+  if (len != sizeof(record) || record.magic != WEAVER_SNAPSHOT_MAGIC ||
+      record.format != WEAVER_SNAPSHOT_FORMAT ||
+      record.checksum != computeChecksum(record)) {
+    LOG_E(TAG, "Discard invalid snapshot");
+    invalidateLocked();
+    return false;
+  }
+  mRecord = record;
+  mIsUsable = true;
+  LOG_D(TAG, "Snapshot Slots (%u) Applet version (0x%04X)", record.slots,
+        record.appletVersion);
+  return true;
+}
+
+/**
+ * \brief Function to get the slot information of the snapshot
+ * \param[out]   slotInfo -     slot information of the snapshot
+ *
+ * \retval This function return true if the snapshot is usable
+ *         and false in other cases.
+ */
+bool WeaverSlotSnapshot::get(SlotInfo &slotInfo) {
+  std::lock_guard<std::mutex> lock(mLock);
+  if (!mIsUsable) {
+    return false;
+  }
+  slotInfo.slots = mRecord.slots;
+  slotInfo.keySize = mRecord.keySize;
+  slotInfo.valueSize = mRecord.valueSize;
+  return true;
+}
+
+/**
+ * \brief Function to update the snapshot with slot information validated
+ * against the applet, file is written only if the information changed
+ * \param[in]    slotInfo -     slot information read from applet
+ * \param[in]    appletVersion - version of the applet, 0 if unknown
+ */
+void WeaverSlotSnapshot::update(const SlotInfo &slotInfo,
+                                uint16_t appletVersion) {
+  std::lock_guard<std::mutex> lock(mLock);
+  if (mIsUsable && mRecord.slots == slotInfo.slots &&
+      mRecord.keySize == slotInfo.keySize &&
+      mRecord.valueSize == slotInfo.valueSize &&
+      (appletVersion == 0 || mRecord.appletVersion == appletVersion)) {
+    return;
+  }
+  if (mIsUsable) {
+    LOG_E(TAG, "Snapshot doesn't match applet, replacing it");
+    invalidateLocked();
+  }
+  Record record = {};
+  record.magic = WEAVER_SNAPSHOT_MAGIC;
+  record.format = WEAVER_SNAPSHOT_FORMAT;
+  record.appletVersion = appletVersion;
+  record.slots = slotInfo.slots;
+  record.keySize = slotInfo.keySize;
+  record.valueSize = slotInfo.valueSize;
+  record.checksum = computeChecksum(record);
+  if (write(record)) {
+    mRecord = record;
+    mIsUsable = true;
+  }
+}
+
+/**
+ * \brief Function to invalidate the snapshot if the applet version differs
+ * \param[in]    appletVersion - version of the applet, 0 if unknown
+ */
+void WeaverSlotSnapshot::checkVersion(uint16_t appletVersion) {
+  std::lock_guard<std::mutex> lock(mLock);
+  if (mIsUsable && appletVersion != 0 &&
+      mRecord.appletVersion != appletVersion) {
+    LOG_E(TAG, "Applet version (0x%04X) differs from snapshot (0x%04X)",
+          appletVersion, mRecord.appletVersion);
+    invalidateLocked();
+  }
+}
+
+/**
+ * \brief Function to invalidate the snapshot and remove the file
+ */
+void WeaverSlotSnapshot::invalidate() {
+  std::lock_guard<std::mutex> lock(mLock);
+  invalidateLocked();
+}
+
+/* Invalidates the snapshot, caller holds mLock */
+void WeaverSlotSnapshot::invalidateLocked() {
+  mIsUsable = false;
+  if (unlink(WEAVER_SNAPSHOT_PATH) != 0 && errno != ENOENT) {
+    LOG_E(TAG, "Failed to remove snapshot (%s)", strerror(errno));
+  }
+}
+
+/* Writes the record to file atomically, caller holds mLock */
+bool WeaverSlotSnapshot::write(const Record &record) {
+  int fd = TEMP_FAILURE_RETRY(open(WEAVER_SNAPSHOT_TMP_PATH,
+                                   O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                                   S_IRUSR | S_IWUSR));
+  if (fd < 0) {
+    LOG_E(TAG, "Failed to create snapshot (%s)", strerror(errno));
+    return false;
+  }
+  bool status =
+      TEMP_FAILURE_RETRY(::write(fd, &record, sizeof(record))) ==
+          sizeof(record) &&
+      fsync(fd) == 0;
+  close(fd);
+  if (!status || rename(WEAVER_SNAPSHOT_TMP_PATH, WEAVER_SNAPSHOT_PATH) != 0) {
+    LOG_E(TAG, "Failed to write snapshot (%s)", strerror(errno));
+    unlink(WEAVER_SNAPSHOT_TMP_PATH);
+    return false;
+  }
+  LOG_D(TAG, "Snapshot written, Slots (%u)", record.slots);
+  return true;
+}
+
+/* Checksum of the record, excluding the checksum field */
+uint32_t WeaverSlotSnapshot::computeChecksum(const Record &record) {
+  const uint8_t *data = (const uint8_t *)&record;
+  uint32_t hash = FNV_OFFSET_BASIS;
+  for (size_t i = 0; i < offsetof(Record, checksum); i++) {
+    hash = (hash ^ data[i]) * FNV_PRIME;
+  }
+  return hash;
+}
@@ -0,0 +1,138 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "weaver-throttle-ledger"
+#include <weaver_throttle_ledger.h>
+#include <weaver_utils.h>
+
+/* Minimum window opened when applet reports throttle by itself */
+#define WEAVER_THROTTLE_MIN_TIMEOUT (30 * 1000) // 30 secs
+
+/**
+ * \brief Function to get remaining throttle time of a slot
+ * \param[in]    slotId -       slot to be checked
+ *
+ * \retval This function return time in ms before the slot may be read
+ *         again, 0 if the slot is not throttled.
+ */
+uint32_t WeaverThrottleLedger::remaining(uint32_t slotId) {
+  std::lock_guard<std::mutex> lock(mLock);
+  auto it = mEntries.find(slotId);
+  if (it == mEntries.end()) {
+    return 0;
+  }
+  auto now = std::chrono::steady_clock::now();
+  if (now >= it->second.windowEnd) {
+    return 0;
+  }
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             it->second.windowEnd - now)
+      .count();
+}
+
+/**
+ * \brief Function to record a failed read with incorrect key
+ * \param[in]    slotId -       slot which failed
+ *
+ * \retval This function return time in ms to wait before next read.
+ */
+uint32_t WeaverThrottleLedger::recordFailure(uint32_t slotId) {
+  std::lock_guard<std::mutex> lock(mLock);
+  Entry &entry = mEntries[slotId];
+  if (entry.failures < WEAVER_THROTTLE_MAX_FAILURES) {
+    entry.failures++;
+  }
+  uint32_t timeout = computeTimeout(entry.failures);
+  openWindow(entry, timeout);
+  LOG_D(TAG, "Slot (%u) failures (%u), timeout (%u) ms", slotId,
+        entry.failures, timeout);
+  return timeout;
+}
+
+/**
+ * \brief Function to record a read rejected by the applet as throttled
+ * \param[in]    slotId -       slot which is throttled
+ *
+ * \retval This function return time in ms to wait before next read.
+ */
+uint32_t WeaverThrottleLedger::recordThrottle(uint32_t slotId) {
+  std::lock_guard<std::mutex> lock(mLock);
+  Entry &entry = mEntries[slotId];
+  /* applet may have counted failures unknown to host, e.g. before restart */
+  uint32_t timeout = computeTimeout(entry.failures);
+  if (timeout < WEAVER_THROTTLE_MIN_TIMEOUT) {
+    timeout = WEAVER_THROTTLE_MIN_TIMEOUT;
+  }
+  openWindow(entry, timeout);
+  LOG_D(TAG, "Slot (%u) throttled by applet, timeout (%u) ms", slotId, timeout);
+  return timeout;
+}
+
+/**
+ * \brief Function to reset the record of a slot, on successful read or
+ * write of the slot
+ * \param[in]    slotId -       slot to be reset
+ */
+void WeaverThrottleLedger::reset(uint32_t slotId) {
+  std::lock_guard<std::mutex> lock(mLock);
+  mEntries.erase(slotId);
+}
+
+/**
+ * \brief Function to reset the record of all slots
+ */
+void WeaverThrottleLedger::clear() {
+  std::lock_guard<std::mutex> lock(mLock);
+  mEntries.clear();
+}
+
+/* Boundaries of the Weaver throttling schedule, checked at build time */
+static constexpr struct {
+  uint32_t failures;
+  uint32_t timeout;
+} kScheduleBoundaries[] = {
+    {0, 0},
+    {4, 0},
+    {5, 30 * 1000},
+    {6, 0},
+    {10, 30 * 1000},
+    {11, 30 * 1000},
+    {30, 30 * 1000},
+    {31, 30 * 1000},
+    {40, 60 * 1000},
+    {139, (30 * 1000) << 10},
+    {140, 24 * 60 * 60 * 1000},
+    {WEAVER_THROTTLE_MAX_FAILURES, 24 * 60 * 60 * 1000},
+};
+
+static constexpr bool isScheduleFollowed() {
+  for (const auto &boundary : kScheduleBoundaries) {
+    if (WeaverThrottleLedger::computeTimeout(boundary.failures) !=
+        boundary.timeout) {
+      return false;
+    }
+  }
+  return true;
+}
+static_assert(isScheduleFollowed(), "Throttle timeout off Weaver schedule");
+
+/* Opens throttle window of timeoutMs for the entry, caller holds mLock */
+void WeaverThrottleLedger::openWindow(Entry &entry, uint32_t timeoutMs) {
+  entry.windowEnd =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+}
@@ -32,15 +32,47 @@ std::vector<uint8_t> kAppletId;
 /* Interface instance of libese-transport library */
 static std::unique_ptr<se_transport::TransportFactory> pTransportFactory =
     nullptr;
+/* Lock to guard lazy creation of pTransportFactory and kAppletId update */
+static std::mutex sTransportFactoryLock;
+
+/* Registered listener for transport events */
+static void *pEventCtx = nullptr;
+static WEAVER_EVENT_CB pEventCb = nullptr;
+
+/**
+ * \brief static function to forward lib-ese-transport events to listener
+ */
+static void transportEventFunc(void *ctx, keymint::javacard::TransportEvent event) {
+  UNUSED(ctx);
+  if (pEventCb == nullptr) {
+    return;
+  }
+  switch (event) {
+  case keymint::javacard::TransportEvent::SE_CONNECTED:
+    pEventCb(pEventCtx, TRANSPORT_EVENT_SE_CONNECTED);
+    break;
+  case keymint::javacard::TransportEvent::APPLET_UPDATE_DETECTED:
+    pEventCb(pEventCtx, TRANSPORT_EVENT_APPLET_UPDATE);
+    break;
+  case keymint::javacard::TransportEvent::APPLET_SELECTED:
+    pEventCb(pEventCtx, TRANSPORT_EVENT_APPLET_SELECTED);
+    break;
+  }
+}
 
 /**
  * \brief static inline function to get lib-ese-transport interface instance
  */
 static inline std::unique_ptr<se_transport::TransportFactory> &
 getTransportFactoryInstance() {
+  std::lock_guard<std::mutex> lock(sTransportFactoryLock);
   if (pTransportFactory == nullptr) {
     pTransportFactory = std::unique_ptr<se_transport::TransportFactory>(
         new se_transport::TransportFactory(kAppletId));
+    pTransportFactory->setEventCallback(nullptr, transportEventFunc);
+    /* weaver reads come in bursts, learn the idle timeout from their gaps */
+    pTransportFactory->setSessionTimeoutPolicy(
+        std::make_shared<se_transport::AdaptiveSessionTimeoutPolicy>());
     pTransportFactory->openConnection();
   }
   return pTransportFactory;
@@ -77,8 +109,9 @@ void WeaverTransportImpl::createInstance() {
  * \retval This function return true in case of success
  *         In case of failure returns false.
  */
-bool WeaverTransportImpl::Init(std::vector<uint8_t> aid) {
+bool WeaverTransportImpl::Init(const std::vector<uint8_t> &aid) {
   LOG_D(TAG, "Entry");
+  std::lock_guard<std::mutex> lock(sTransportFactoryLock);
   kAppletId = aid;
   LOG_D(TAG, "Exit");
   return true;
@@ -88,17 +121,18 @@ bool WeaverTransportImpl::Init(std::vector<uint8_t> aid) {
  * \brief Function to open applet connection
  *
  * \param[in]    data -         command for open applet
- * \param[out]   resp -         response from applet
+ * \param[in,out] resp -        buffer for response from applet, narrowed to
+ *                              the response length
  *
  * \retval This function return true in case of success
  *         In case of failure returns false.
  */
-bool WeaverTransportImpl::OpenApplet(std::vector<uint8_t> data,
-                                     std::vector<uint8_t> &resp) {
+bool WeaverTransportImpl::OpenApplet(std::span<const uint8_t> data,
+                                     std::span<uint8_t> &resp) {
   LOG_D(TAG, "Entry");
   bool status = true;
   UNUSED(data);
-  UNUSED(resp);
+  resp = resp.first(0);
   // Since libese_transport opens channel as part of send only so open applet is
   // not required
   LOG_D(TAG, "Exit");
@@ -113,8 +147,9 @@ bool WeaverTransportImpl::OpenApplet(std::vector<uint8_t> data,
  */
 bool WeaverTransportImpl::CloseApplet() {
   LOG_D(TAG, "Entry");
-  // Close the Applet Channel if opened
-  bool status = getTransportFactoryInstance()->closeConnection();
+  // Close the Applet Channel if opened, releasing the SE logical channel is
+  // enough, session & reader are reused by the next open
+  bool status = getTransportFactoryInstance()->closeChannel();
   LOG_D(TAG, "Exit");
   return status;
 }
@@ -123,17 +158,32 @@ bool WeaverTransportImpl::CloseApplet() {
  * \brief Function to send commands to applet
  *
  * \param[in]    data -         command to be send to applet
- * \param[out]   resp -         response from applet
+ * \param[in,out] resp -        buffer for response from applet, narrowed to
+ *                              the response length
  *
  * \retval This function return true in case of success
  *         In case of failure returns false.
  */
-bool WeaverTransportImpl::Send(std::vector<uint8_t> data,
-                               std::vector<uint8_t> &resp) {
+bool WeaverTransportImpl::Send(std::span<const uint8_t> data,
+                               std::span<uint8_t> &resp) {
   LOG_D(TAG, "Entry");
   // Opens the channel with aid and transmit the data
-  bool status =
-      getTransportFactoryInstance()->sendData(data.data(), data.size(), resp);
+  bool status = getTransportFactoryInstance()->sendData(data, resp);
+  LOG_D(TAG, "Exit");
+  return status;
+}
+
+/**
+ * \brief Function to get select response of the applet
+ *
+ * \param[out]   resp -         select response of the last opened channel
+ *
+ * \retval This function return true in case of success
+ *         In case of failure returns false.
+ */
+bool WeaverTransportImpl::GetSelectResponse(std::vector<uint8_t> &resp) {
+  LOG_D(TAG, "Entry");
+  bool status = getTransportFactoryInstance()->getSelectResponse(resp);
   LOG_D(TAG, "Exit");
   return status;
 }
@@ -146,7 +196,33 @@ bool WeaverTransportImpl::Send(std::vector<uint8_t> data,
  */
 bool WeaverTransportImpl::DeInit() {
   LOG_D(TAG, "Entry");
-  bool status = CloseApplet();
+  bool status = getTransportFactoryInstance()->closeConnection();
   LOG_D(TAG, "Exit");
   return status;
 }
+
+/**
+ * \brief Function to register callback for transport events
+ *
+ * \param[in]    ctx -          context passed back to the callback
+ * \param[in]    cb -           callback to be invoked on transport events
+ */
+void WeaverTransportImpl::RegisterEventCallback(void *ctx, WEAVER_EVENT_CB cb) {
+  LOG_D(TAG, "Entry");
+  std::lock_guard<std::mutex> lock(sTransportFactoryLock);
+  pEventCtx = ctx;
+  pEventCb = cb;
+  LOG_D(TAG, "Exit");
+}
+
+/**
+ * \brief Function to set the lower bound of the channel idle timeout
+ *
+ * \param[in]    timeoutMs -    period in ms the transport keeps an idle
+ *                              channel open at least, 0 for none
+ */
+void WeaverTransportImpl::SetMinSessionTimeout(uint32_t timeoutMs) {
+  LOG_D(TAG, "Entry");
+  getTransportFactoryInstance()->setMinSessionTimeout(timeoutMs);
+  LOG_D(TAG, "Exit");
+}
@@ -0,0 +1,284 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+#define LOG_TAG "AidlSeTransport"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <android-base/logging.h>
+#include <android-base/stringprintf.h>
+
+#include <AidlSeTransport.h>
+#include <EseTransportUtils.h>
+
+namespace keymint::javacard {
+
+using ::aidl::android::hardware::secure_element::BnSecureElementCallback;
+using ::aidl::android::hardware::secure_element::ISecureElement;
+using ::aidl::android::hardware::secure_element::LogicalChannelResponse;
+
+class AidlSeCallback : public BnSecureElementCallback {
+  public:
+    AidlSeCallback(AidlSeTransport* transport) : mTransport(transport) {}
+    ::ndk::ScopedAStatus onStateChange(bool state, const std::string& reason) override {
+        LOGD_OMAPI("connected =" << (state ? "true " : "false ") << "reason: " << reason);
+        mTransport->onStateChange(state);
+        return ::ndk::ScopedAStatus::ok();
+    }
+  private:
+    AidlSeTransport* mTransport;
+};
+
+void aidlSeSessionTimerFunc(union sigval arg) {
+    LOG(INFO) << "Session Timer expired !!";
+    AidlSeTransport* obj = (AidlSeTransport*)arg.sival_ptr;
+    if (obj != nullptr) obj->closeChannel();
+}
+
+static void aidlSeServiceDied(void* cookie) {
+    LOG(ERROR) << "Secure Element Service died disconnecting SE HAL .....";
+    AidlSeTransport* obj = (AidlSeTransport*)cookie;
+    if (obj != nullptr) obj->onStateChange(false);
+}
+
+/* Highest logical channel number encodable in CLA, ISO 7816-4 */
+#define MAX_LOGICAL_CHANNEL (19)
+
+/* CLA of a command sent on logical channel, ISO 7816-4 first & further
+ * interindustry classes. Channel must not exceed MAX_LOGICAL_CHANNEL */
+static uint8_t channelCla(uint8_t cla, int8_t channel) {
+    if (channel < 4) {
+        return (cla & 0xBC) | channel;
+    }
+    return (cla & 0xB0) | 0x40 | (channel - 4);
+}
+
+bool AidlSeTransport::openConnection() {
+    if (isConnected()) {
+        return true;
+    }
+    // devices without the AIDL eSE HAL don't declare it, don't wait for it
+    if (!AServiceManager_isDeclared(seHalServiceName)) {
+        LOG(ERROR) << "eSE HAL service " << seHalServiceName << " not declared";
+        return false;
+    }
+    ::ndk::SpAIBinder binder(AServiceManager_waitForService(seHalServiceName));
+    auto client = ISecureElement::fromBinder(binder);
+    if (client == nullptr) {
+        LOG(ERROR) << "Failed to get eSE HAL service " << seHalServiceName;
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mChannelLock);
+    mSEClient = client;
+    mSEConnected = false;
+    // channels of a previous HAL instance are gone
+    mOpenChannel = -1;
+    if (mCallback == nullptr) {
+        mCallback = ndk::SharedRefBase::make<AidlSeCallback>(this);
+    }
+    if (mDeathRecipient.get() == nullptr) {
+        mDeathRecipient = ::ndk::ScopedAIBinder_DeathRecipient(
+                AIBinder_DeathRecipient_new(aidlSeServiceDied));
+    }
+    if (AIBinder_linkToDeath(binder.get(), mDeathRecipient.get(), this) != STATUS_OK) {
+        LOG(ERROR) << "Failed to link to eSE HAL death";
+    }
+    auto res = mSEClient->init(mCallback);
+    if (!res.isOk()) {
+        LOG(ERROR) << "init error: " << res.getMessage();
+        mSEClient = nullptr;
+        return false;
+    }
+    // state is reported by a oneway callback, arriving after init returned
+    {
+        std::unique_lock<std::mutex> stateLock(mStateLock);
+        mStateCond.wait_for(stateLock, std::chrono::milliseconds(SE_CONNECT_TIMEOUT),
+                            [this] { return mSEConnected.load(); });
+    }
+    if (!mSEConnected) {
+        LOG(ERROR) << "eSE not connected after init";
+        mSEClient = nullptr;
+        return false;
+    }
+    notifyEvent(TransportEvent::SE_CONNECTED);
+    return true;
+}
+
+void AidlSeTransport::onStateChange(bool connected) {
+    {
+        std::lock_guard<std::mutex> lock(mStateLock);
+        mSEConnected = connected;
+    }
+    mStateCond.notify_all();
+}
+
+bool AidlSeTransport::openChannelLocked(std::vector<uint8_t>& selectResponse) {
+    LogicalChannelResponse response;
+    auto res = mSEClient->openLogicalChannel(mSelectableAid, 0x00, &response);
+    if (!res.isOk()) {
+        LOG(ERROR) << "openLogicalChannel error: " << res.getMessage();
+        return false;
+    }
+    mOpenChannel = response.channelNumber;
+    LOG(INFO) << "openLogicalChannel: channelNumber = "
+              << ::android::base::StringPrintf("%d", mOpenChannel);
+    if (mOpenChannel < 1 || mOpenChannel > MAX_LOGICAL_CHANNEL) {
+        LOG(ERROR) << "channel number can't be encoded in CLA";
+        closeChannelLocked();
+        return false;
+    }
+    if (response.selectResponse.size() < 2) {
+        LOG(ERROR) << "getSelectResponse size error";
+        closeChannelLocked();
+        return false;
+    }
+    selectResponse = response.selectResponse;
+    return true;
+}
+
+bool AidlSeTransport::sendData(std::span<const uint8_t> inData, std::span<uint8_t>& output) {
+#ifdef INTERVAL_TIMER
+     LOGD_OMAPI("stop the timer");
+     mTimer.kill();
+     mSessionTimeoutPolicy->onApdu();
+#endif
+    if (inData.size() == 0x00) {
+        LOG(ERROR) << "Failed to send data, APDU is null";
+        return false;
+    }
+    if (!openConnection()) {
+        LOG(ERROR) << "Failed to send data, not connected to eSE HAL";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mChannelLock);
+    if (mOpenChannel < 0) {
+#ifdef NXP_EXTNS
+        if (!mSBAccessController.isSelectAllowed()) {
+            LOG(ERROR) << "Select not allowed";
+            std::vector<uint8_t> error;
+            prepareErrorRepsponse(error);
+            copyResponse(error.data(), error.size(), output);
+            return false;
+        }
+#endif
+        std::vector<uint8_t> selectResponse;
+        if (!openChannelLocked(selectResponse)) {
+            return false;
+        }
+        onAppletSelected(selectResponse);
+#ifdef NXP_EXTNS
+        if (mSBAccessController.parseResponse(selectResponse)) {
+            notifyEvent(TransportEvent::APPLET_UPDATE_DETECTED);
+        }
+#endif
+    }
+
+#ifdef NXP_EXTNS
+    if (!mSBAccessController.isOperationAllowed(inData[APDU_INS_OFFSET])) {
+        LOG(ERROR) << "command Ins:" << inData[APDU_INS_OFFSET] << " not allowed";
+        std::vector<uint8_t> error;
+        prepareErrorRepsponse(error);
+        copyResponse(error.data(), error.size(), output);
+        return false;
+    }
+#endif
+
+    // only copies in either direction, HAL interface takes & returns vectors
+    std::vector<uint8_t> cmd(inData.begin(), inData.end());
+    cmd[0] = channelCla(cmd[0], mOpenChannel);
+    std::vector<uint8_t> response;
+    auto res = mSEClient->transmit(cmd, &response);
+    // command may carry secrets
+    std::fill(cmd.begin(), cmd.end(), 0);
+    if (!res.isOk()) {
+        LOG(ERROR) << "transmit error: " << res.getMessage();
+        // channel may be stale, e.g. SE reset, reopen on next command
+        closeChannelLocked();
+        return false;
+    }
+    if (response.size() < 2 ||
+        (response[response.size() - 2] == LOGICAL_CH_NOT_SUPPORTED_SW1 &&
+         response[response.size() - 1] == LOGICAL_CH_NOT_SUPPORTED_SW2)) {
+        LOGD_OMAPI("transmit failed ,close the channel");
+        closeChannelLocked();
+    }
+    if (!copyResponse(response.data(), response.size(), output)) {
+        return false;
+    }
+
+#ifdef INTERVAL_TIMER
+     int timeout = mSessionTimeoutPolicy->getSessionTimeout(
+             mSBAccessController.getSessionTimeout());
+     if(timeout == 0) {
+       closeChannelLocked(); //close immediately
+     } else {
+       LOGD_OMAPI("Set the timer with timeout " << timeout << " ms");
+       mTimer.set(timeout, this, aidlSeSessionTimerFunc);
+     }
+#else
+     closeChannelLocked();
+#endif
+    return true;
+}
+
+void AidlSeTransport::closeChannelLocked() {
+    if (mSEClient == nullptr || mOpenChannel < 0) {
+        return;
+    }
+    auto res = mSEClient->closeChannel(mOpenChannel);
+    if (!res.isOk()) {
+        /*
+         * reason could be SE reset or HAL deinit triggered from other client
+         * which anyway closes all the opened channels
+         * */
+        LOG(ERROR) << "closeChannel failed: " << res.getMessage();
+    }
+    mOpenChannel = -1;
+}
+
+void AidlSeTransport::prepareErrorRepsponse(std::vector<uint8_t>& resp){
+        resp.clear();
+        resp.push_back(0xFF);
+        resp.push_back(0xFF);
+}
+
+bool AidlSeTransport::closeChannel() {
+    std::lock_guard<std::mutex> lock(mChannelLock);
+    closeChannelLocked();
+    return true;
+}
+
+bool AidlSeTransport::closeConnection() {
+#ifdef INTERVAL_TIMER
+    mTimer.kill();
+#endif
+    std::lock_guard<std::mutex> lock(mChannelLock);
+    closeChannelLocked();
+    mSEClient = nullptr;
+    mSEConnected = false;
+    return true;
+}
+
+bool AidlSeTransport::isConnected() {
+    std::lock_guard<std::mutex> lock(mChannelLock);
+    return mSEClient != nullptr && mSEConnected;
+}
+
+}  // namespace keymint::javacard
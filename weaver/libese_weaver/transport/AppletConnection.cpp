@@ -42,6 +42,7 @@
 #include <iomanip>
 #include <mutex>
 #include <string>
+#include <algorithm>
 #include <vector>
 
 #include <AppletConnection.h>
@@ -184,8 +185,10 @@ bool AppletConnection::openChannelToApplet(std::vector<uint8_t>& resp) {
   return ret;
 }
 
-bool AppletConnection::transmit(std::vector<uint8_t>& CommandApdu , std::vector<uint8_t>& output){
-    hidl_vec<uint8_t> cmd = CommandApdu;
+bool AppletConnection::transmit(std::span<const uint8_t> CommandApdu,
+                                std::span<uint8_t>& output) {
+    // only copy of the command, CLA is patched with the channel number
+    hidl_vec<uint8_t> cmd(CommandApdu.begin(), CommandApdu.end());
     cmd[0] |= mOpenChannel ;
     LOGD_OMAPI("Channel number " << ::android::hardware::toString(mOpenChannel));
 
@@ -195,27 +198,41 @@ bool AppletConnection::transmit(std::vector<uint8_t>& CommandApdu , std::vector<
             std::vector<uint8_t> ins;
             ins.push_back(CommandApdu[APDU_INS_OFFSET]);
             LOG(ERROR) << "command Ins:" << ins << " not allowed";
-            prepareErrorRepsponse(output);
+            std::vector<uint8_t> error;
+            prepareErrorRepsponse(error);
+            copyResponse(error.data(), error.size(), output);
             return false;
         }
     }
     // block any fatal signal delivery
     SignalHandler::getInstance()->blockSignals();
 
+    bool status = false;
     mSEClient->transmit(cmd, [&](hidl_vec<uint8_t> result) {
-        output = result;
+        status = copyResponse(result.data(), result.size(), output);
         LOG(INFO) << "recieved response size = " << ::android::hardware::toString(result.size()) << " data = " << result;
     });
+    // command may carry secrets
+    std::fill(cmd.begin(), cmd.end(), 0);
+    if (!status) output = output.first(0);
 
     // un-block signal delivery
     SignalHandler::getInstance()->unblockSignals();
-    return true;
+    return status;
 }
 
 int AppletConnection::getSessionTimeout() {
     return mSBAccessController.getSessionTimeout();
 }
 
+bool AppletConnection::isAppletUpdateInProgress() {
+    return mSBAccessController.isUpdateInProgress();
+}
+
+bool AppletConnection::isServiceConnected() {
+    return mSEClient != nullptr && mCallback != nullptr && mCallback->isClientConnected();
+}
+
 bool AppletConnection::close() {
     std::lock_guard<std::mutex> lock(channel_mutex_);
     if (mSEClient == nullptr) {
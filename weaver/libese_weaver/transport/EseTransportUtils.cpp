@@ -14,9 +14,12 @@
  ** limitations under the License.
  **
  */
+#include <algorithm>
 #include <vector>
 #include <iomanip>
 
+#include <android-base/logging.h>
+
 #include <EseTransportUtils.h>
 
 namespace keymint::javacard {
@@ -29,4 +32,16 @@ std::ostream& operator<<(std::ostream& os, const std::vector<uint8_t>& vec) {
   os << " }";
   return os;
 }
+
+// Copies response into caller buffer and narrows the view to its length
+bool copyResponse(const uint8_t* data, size_t len, std::span<uint8_t>& output) {
+  if (len > output.size()) {
+    LOG(ERROR) << "Response of " << len << " bytes exceeds buffer of " << output.size();
+    output = output.first(0);
+    return false;
+  }
+  std::copy(data, data + len, output.begin());
+  output = output.first(len);
+  return true;
+}
 } // namespace keymint::javacard
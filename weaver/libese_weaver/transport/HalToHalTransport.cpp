@@ -53,39 +53,53 @@ void SessionTimerFunc(union sigval arg){
        obj->closeConnection();
 }
 bool HalToHalTransport::openConnection() {
-	  return mAppletConnection.connectToSEService();
+    bool wasConnected = mAppletConnection.isServiceConnected();
+    bool status = mAppletConnection.connectToSEService();
+    if (status && !wasConnected) {
+        notifyEvent(TransportEvent::SE_CONNECTED);
+    }
+    return status;
 }
 
-bool HalToHalTransport::sendData(const vector<uint8_t>& inData, vector<uint8_t>& output) {
+bool HalToHalTransport::sendData(std::span<const uint8_t> inData, std::span<uint8_t>& output) {
     bool status = false;
-    std::vector<uint8_t> cApdu(inData);
 #ifdef INTERVAL_TIMER
      LOGD_OMAPI("stop the timer");
      mTimer.kill();
+     mSessionTimeoutPolicy->onApdu();
 #endif
      if (!isConnected()) {
          std::vector<uint8_t> selectResponse;
+         bool wasConnected = mAppletConnection.isServiceConnected();
          status = mAppletConnection.openChannelToApplet(selectResponse);
          if (!status) {
              LOG(ERROR) << " Failed to open Logical Channel ,response " << selectResponse;
-             output = selectResponse;
+             copyResponse(selectResponse.data(), selectResponse.size(), output);
              return status;
          }
+         if (!wasConnected) {
+             notifyEvent(TransportEvent::SE_CONNECTED);
+         }
+         onAppletSelected(selectResponse);
+         if (mAppletConnection.isAppletUpdateInProgress()) {
+             notifyEvent(TransportEvent::APPLET_UPDATE_DETECTED);
+         }
      }
-    status = mAppletConnection.transmit(cApdu, output);
+    status = mAppletConnection.transmit(inData, output);
     if (output.size() < 2 ||
-        (output.size() >= 2 && (output.at(output.size() - 2) == LOGICAL_CH_NOT_SUPPORTED_SW1 &&
-                                output.at(output.size() - 1) == LOGICAL_CH_NOT_SUPPORTED_SW2))) {
+        (output.size() >= 2 && (output[output.size() - 2] == LOGICAL_CH_NOT_SUPPORTED_SW1 &&
+                                output[output.size() - 1] == LOGICAL_CH_NOT_SUPPORTED_SW2))) {
         LOGD_OMAPI("transmit failed ,close the channel");
         return mAppletConnection.close();
     }
 #ifdef INTERVAL_TIMER
-     int timeout = mAppletConnection.getSessionTimeout();
+     int timeout = mSessionTimeoutPolicy->getSessionTimeout(
+             mAppletConnection.getSessionTimeout());
      if(timeout == 0) {
        closeConnection(); //close immediately
      } else {
        LOGD_OMAPI("Set the timer with timeout " << timeout << " ms");
-       mTimer.set(mAppletConnection.getSessionTimeout(), this, SessionTimerFunc);
+       mTimer.set(timeout, this, SessionTimerFunc);
      }
 #endif
     return status;
@@ -38,6 +38,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
+#include <algorithm>
 #include <vector>
 #include <iomanip>
 
@@ -55,14 +56,20 @@ namespace keymint::javacard {
 
 class SEListener : public ::aidl::android::se::omapi::BnSecureElementListener {};
 
-#ifdef NXP_EXTNS
 void omapiSessionTimerFunc(union sigval arg){
      LOG(INFO) << "Session Timer expired !!";
      OmapiTransport *obj = (OmapiTransport*)arg.sival_ptr;
      if(obj != nullptr)
        obj->closeSession();
 }
-#endif
+
+/* OMAPI service died, its reader handle is stale: rediscover on next use */
+static void omapiServiceDied(void* cookie) {
+    LOG(ERROR) << "OMAPI service died";
+    OmapiTransport *obj = (OmapiTransport*)cookie;
+    if (obj != nullptr)
+      obj->invalidateReader();
+}
 
 bool OmapiTransport::initialize() {
     std::vector<std::string> readers = {};
@@ -72,78 +79,99 @@ bool OmapiTransport::initialize() {
     // Get OMAPI vendor stable service handler
 #ifdef NXP_EXTNS
     ::ndk::SpAIBinder ks2Binder(AServiceManager_checkService(omapiServiceName));
-    omapiSeService = aidl::android::se::omapi::ISecureElementService::fromBinder(ks2Binder);
 #else
     ::ndk::SpAIBinder ks2Binder(AServiceManager_getService(omapiServiceName));
-    omapiSeService = aidl::android::se::omapi::ISecureElementService::fromBinder(ks2Binder);
 #endif
+    auto service = aidl::android::se::omapi::ISecureElementService::fromBinder(ks2Binder);
 
-    if (omapiSeService == nullptr) {
+    if (service == nullptr) {
         LOG(ERROR) << "Failed to start omapiSeService null";
         return false;
     }
 
-    // reset readers, clear readers if already existing
-    if (mVSReaders.size() > 0) {
-        closeConnection();
-    }
-
     // Get available readers
-    auto status = omapiSeService->getReaders(&readers);
+    auto status = service->getReaders(&readers);
     if (!status.isOk()) {
         LOG(ERROR) << "getReaders failed to get available readers: " << status.getMessage();
         return false;
     }
 
-    // Get SE readers handlers
-    for (auto readerName : readers) {
-        std::shared_ptr<::aidl::android::se::omapi::ISecureElementReader> reader;
-        status = omapiSeService->getReader(readerName, &reader);
-        if (!status.isOk()) {
-            LOG(ERROR) << "getReader for " << readerName.c_str() << " Failed: "
-                       << status.getMessage();
-            return false;
-        }
-
-        mVSReaders[readerName] = reader;
-    }
-
-    // Find eSE reader, as of now assumption is only eSE available on device
+    // Find eSE reader, as of now assumption is only eSE available on device.
+    // Only the chosen reader is fetched, other readers (UICC...) are skipped
     LOG(DEBUG) << "Finding eSE reader";
-    eSEReader = nullptr;
-    if (mVSReaders.size() > 0) {
-        for (const auto& [name, reader] : mVSReaders) {
-            if (name.find(ESE_READER_PREFIX, 0) != std::string::npos) {
-                LOG(DEBUG) << "eSE reader found: " << name;
-                eSEReader = reader;
+    std::sort(readers.begin(), readers.end());
+    std::string eSEReaderName;
+    for (const auto& name : readers) {
+        if (name.find(ESE_READER_PREFIX, 0) != std::string::npos) {
+            LOG(DEBUG) << "eSE reader found: " << name;
+            eSEReaderName = name;
 #ifdef NXP_EXTNS
-                std::string prefTerminalName = "eSE1";
-                if (name.compare(prefTerminalName) == 0x00 ) {
-                    LOG(DEBUG) << "Found reader "<< prefTerminalName << " breaking.";
-                    break;
-                }
-#endif
+            std::string prefTerminalName = "eSE1";
+            if (name.compare(prefTerminalName) == 0x00 ) {
+                LOG(DEBUG) << "Found reader "<< prefTerminalName << " breaking.";
+                break;
             }
+#endif
         }
     }
 
-    if (eSEReader == nullptr) {
+    if (eSEReaderName.empty()) {
         LOG(ERROR) << "secure element reader " << ESE_READER_PREFIX << " not found";
         return false;
     }
 
+    std::shared_ptr<::aidl::android::se::omapi::ISecureElementReader> reader;
+    status = service->getReader(eSEReaderName, &reader);
+    if (!status.isOk() || reader == nullptr) {
+        LOG(ERROR) << "getReader for " << eSEReaderName.c_str() << " Failed: "
+                   << status.getMessage();
+        return false;
+    }
+
+    if (mDeathRecipient.get() == nullptr) {
+        mDeathRecipient = ::ndk::ScopedAIBinder_DeathRecipient(
+                AIBinder_DeathRecipient_new(omapiServiceDied));
+    }
+    // link once per service instance, a new instance comes with a new binder
+    if (mOmapiBinder.get() != ks2Binder.get()) {
+        if (AIBinder_linkToDeath(ks2Binder.get(), mDeathRecipient.get(), this) != STATUS_OK) {
+            LOG(ERROR) << "Failed to link to OMAPI service death";
+        } else {
+            mOmapiBinder = ks2Binder;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mReaderLock);
+        omapiSeService = service;
+        eSEReader = reader;
+    }
+    LOG(INFO) << "eSE reader " << eSEReaderName << " cached";
+    notifyEvent(TransportEvent::SE_CONNECTED);
     return true;
 }
 
+void OmapiTransport::invalidateReader() {
+    std::lock_guard<std::mutex> lock(mSessionLock);
+    invalidateReaderLocked();
+}
+
+void OmapiTransport::invalidateReaderLocked() {
+    // session & channel belong to the stale reader, they are dropped unclosed
+    session = nullptr;
+    channel = nullptr;
+    std::lock_guard<std::mutex> lock(mReaderLock);
+    omapiSeService = nullptr;
+    eSEReader = nullptr;
+    mSEPresent = false;
+}
+
+/* Session, channel & listener are kept open across APDUs and closed by the
+ * session timer, so a command costs a single transmit while the channel is up */
 bool OmapiTransport::internalTransmitApdu(
         std::shared_ptr<aidl::android::se::omapi::ISecureElementReader> reader,
-        std::vector<uint8_t> apdu, std::vector<uint8_t>& transmitResponse) {
-    //auto mSEListener = std::make_shared<SEListener>();
-    auto mSEListener = ndk::SharedRefBase::make<SEListener>();
+        const std::vector<uint8_t>& apdu, std::vector<uint8_t>& transmitResponse) {
     std::vector<uint8_t> selectResponse = {};
-    /*std::vector<uint8_t> SELECTABLE_AID = {0xA0, 0x00, 0x00, 0x04, 0x76, 0x41, 0x6E, 0x64,
-        0x72, 0x6F, 0x69, 0x64, 0x43, 0x54, 0x53, 0x31};*/
-
 
     LOG(DEBUG) << "internalTransmitApdu: trasmitting data to secure element";
 
@@ -153,60 +181,117 @@ bool OmapiTransport::internalTransmitApdu(
     }
 
     bool status = false;
-    auto res = reader->isSecureElementPresent(&status);
-    if (!res.isOk()) {
-        LOG(ERROR) << "isSecureElementPresent error: " << res.getMessage();
-        return false;
-    }
-    if (!status) {
-        LOG(ERROR) << "secure element not found";
-        return false;
+    ::ndk::ScopedAStatus res;
+    // presence is queried only until confirmed, then tracked from failures
+    if (!mSEPresent) {
+        res = reader->isSecureElementPresent(&status);
+        if (!res.isOk()) {
+            LOG(ERROR) << "isSecureElementPresent error: " << res.getMessage();
+            invalidateReader();
+            return false;
+        }
+        if (!status) {
+            LOG(ERROR) << "secure element not found";
+            return false;
+        }
+        mSEPresent = true;
     }
 
-    res = reader->openSession(&session);
-    if (!res.isOk()) {
-        LOG(ERROR) << "openSession error: " << res.getMessage();
-        return false;
-    }
-    if (session == nullptr) {
-        LOG(ERROR) << "Could not open session null";
-        return false;
+    std::lock_guard<std::mutex> lock(mSessionLock);
+    // a session or channel which can't tell its state is treated as closed
+    if (session == nullptr || !session->isClosed(&status).isOk() || status) {
+        closeSessionLocked();
+        res = reader->openSession(&session);
+        if (!res.isOk()) {
+            LOG(ERROR) << "openSession error: " << res.getMessage();
+            invalidateReaderLocked();
+            return false;
+        }
+        if (session == nullptr) {
+            LOG(ERROR) << "Could not open session null";
+            mSEPresent = false;
+            return false;
+        }
     }
 
-    res = session->openLogicalChannel(mSelectableAid, 0x00, mSEListener, &channel);
-    if (!res.isOk()) {
-        LOG(ERROR) << "openLogicalChannel error: " << res.getMessage();
-        return false;
-    }
-    if (channel == nullptr) {
-        LOG(ERROR) << "Could not open channel null";
-        return false;
-    }
+    if (channel == nullptr || !channel->isClosed(&status).isOk() || status) {
+#ifdef NXP_EXTNS
+        if (!mSBAccessController.isSelectAllowed()) {
+            LOG(ERROR) << "Select not allowed";
+            prepareErrorRepsponse(transmitResponse);
+            return false;
+        }
+#endif
+        if (mSEListener == nullptr) {
+            mSEListener = ndk::SharedRefBase::make<SEListener>();
+        }
+        res = session->openLogicalChannel(mSelectableAid, 0x00, mSEListener, &channel);
+        if (!res.isOk()) {
+            LOG(ERROR) << "openLogicalChannel error: " << res.getMessage();
+            closeSessionLocked();
+            mSEPresent = false;
+            return false;
+        }
+        if (channel == nullptr) {
+            LOG(ERROR) << "Could not open channel null";
+            closeSessionLocked();
+            return false;
+        }
 
-    res = channel->getSelectResponse(&selectResponse);
-    if (!res.isOk()) {
-        LOG(ERROR) << "getSelectResponse error: " << res.getMessage();
-        return false;
+        res = channel->getSelectResponse(&selectResponse);
+        if (!res.isOk()) {
+            LOG(ERROR) << "getSelectResponse error: " << res.getMessage();
+            closeSessionLocked();
+            return false;
+        }
+        if (selectResponse.size() < 2) {
+            LOG(ERROR) << "getSelectResponse size error";
+            closeSessionLocked();
+            return false;
+        }
+        onAppletSelected(selectResponse);
+#ifdef NXP_EXTNS
+        if (mSBAccessController.parseResponse(selectResponse)) {
+            notifyEvent(TransportEvent::APPLET_UPDATE_DETECTED);
+        }
+#endif
     }
-    if (selectResponse.size() < 2) {
-        LOG(ERROR) << "getSelectResponse size error";
+
+#ifdef NXP_EXTNS
+    if (!mSBAccessController.isOperationAllowed(apdu[APDU_INS_OFFSET])) {
+        LOG(ERROR) << "command Ins:" << apdu[APDU_INS_OFFSET] << " not allowed";
+        prepareErrorRepsponse(transmitResponse);
         return false;
     }
+#endif
 
     res = channel->transmit(apdu, &transmitResponse);
-    if (channel != nullptr) channel->close();
-    if (session != nullptr) session->close();
 
-    LOG(INFO) << "STATUS OF TRNSMIT: " << res.getExceptionCode() << " Message: "
-              << res.getMessage();
+    LOGD_OMAPI("STATUS OF TRNSMIT: " << res.getExceptionCode() << " Message: "
+              << res.getMessage());
     if (!res.isOk()) {
         LOG(ERROR) << "transmit error: " << res.getMessage();
+        // channel may be stale, e.g. SE reset, reopen on next command
+        closeSessionLocked();
+        mSEPresent = false;
         return false;
     }
 
+#ifdef INTERVAL_TIMER
+     int timeout = mSessionTimeoutPolicy->getSessionTimeout(
+             mSBAccessController.getSessionTimeout());
+     if(timeout == 0) {
+       closeSessionLocked(); //close immediately
+     } else {
+       LOGD_OMAPI("Set the timer with timeout " << timeout << " ms");
+       mTimer.set(timeout, this, omapiSessionTimerFunc);
+     }
+#else
+     closeSessionLocked();
+#endif
+
     return true;
 }
-
 bool OmapiTransport::openConnection() {
 
     // if already conection setup done, no need to initialise it again.
@@ -217,11 +302,11 @@ bool OmapiTransport::openConnection() {
     return initialize();
 }
 
-bool OmapiTransport::sendData(const vector<uint8_t>& inData, vector<uint8_t>& output) {
-    std::vector<uint8_t> apdu(inData);
+bool OmapiTransport::sendData(std::span<const uint8_t> inData, std::span<uint8_t>& output) {
 #ifdef INTERVAL_TIMER
      LOGD_OMAPI("stop the timer");
      mTimer.kill();
+     mSessionTimeoutPolicy->onApdu();
 #endif
     if (!isConnected()) {
         // Try to initialize connection to eSE
@@ -238,13 +323,23 @@ bool OmapiTransport::sendData(const vector<uint8_t>& inData, vector<uint8_t>& ou
         return false;
     }
 
-    if (eSEReader != nullptr) {
+    std::shared_ptr<aidl::android::se::omapi::ISecureElementReader> reader;
+    {
+        std::lock_guard<std::mutex> lock(mReaderLock);
+        reader = eSEReader;
+    }
+    if (reader != nullptr) {
         LOG(DEBUG) << "Sending apdu data to secure element: " << ESE_READER_PREFIX;
-#ifdef NXP_EXTNS
-        return internalProtectedTransmitApdu(eSEReader, apdu, output);
-#else
-        return internalTransmitApdu(eSEReader, apdu, output);
-#endif
+        // only copies in either direction, OMAPI interface takes & returns vectors
+        std::vector<uint8_t> apdu(inData.begin(), inData.end());
+        std::vector<uint8_t> response;
+        bool status = internalTransmitApdu(reader, apdu, response);
+        // command may carry secrets
+        std::fill(apdu.begin(), apdu.end(), 0);
+        if (!copyResponse(response.data(), response.size(), output)) {
+            return false;
+        }
+        return status;
     } else {
         LOG(ERROR) << "secure element reader " << ESE_READER_PREFIX << " not found";
         return false;
@@ -253,19 +348,38 @@ bool OmapiTransport::sendData(const vector<uint8_t>& inData, vector<uint8_t>& ou
 
 bool OmapiTransport::closeConnection() {
     LOG(DEBUG) << "Closing all connections";
-    if (omapiSeService != nullptr) {
-        if (mVSReaders.size() > 0) {
-            for (const auto& [name, reader] : mVSReaders) {
-                reader->closeSessions();
-            }
-            mVSReaders.clear();
+#ifdef INTERVAL_TIMER
+    mTimer.kill();
+#endif
+    std::shared_ptr<aidl::android::se::omapi::ISecureElementReader> reader;
+    {
+        std::lock_guard<std::mutex> lock(mReaderLock);
+        reader = eSEReader;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mSessionLock);
+        closeSessionLocked();
+        if (reader != nullptr) {
+            reader->closeSessions();
         }
     }
+    // full disconnect, next command discovers the reader again
+    invalidateReader();
+    return true;
+}
+
+bool OmapiTransport::closeChannel() {
+    LOG(DEBUG) << "Closing channel";
+    std::lock_guard<std::mutex> lock(mSessionLock);
+    if (channel != nullptr) channel->close();
+    channel = nullptr;
+    // session stays open until the session timer expires
     return true;
 }
 
 bool OmapiTransport::isConnected() {
     // Check already initialization completed or not
+    std::lock_guard<std::mutex> lock(mReaderLock);
     if (omapiSeService != nullptr && eSEReader != nullptr) {
         LOG(DEBUG) << "Connection initialization already completed";
         return true;
@@ -275,112 +389,25 @@ bool OmapiTransport::isConnected() {
     return false;
 }
 
-#ifdef NXP_EXTNS
-bool OmapiTransport::internalProtectedTransmitApdu(
-        std::shared_ptr<aidl::android::se::omapi::ISecureElementReader> reader,
-        std::vector<uint8_t> apdu, std::vector<uint8_t>& transmitResponse) {
-    //auto mSEListener = std::make_shared<SEListener>();
-    auto mSEListener = ndk::SharedRefBase::make<SEListener>();
-    std::vector<uint8_t> selectResponse = {};
-
-    if (reader == nullptr) {
-        LOG(ERROR) << "eSE reader is null";
-        return false;
-    }
-
-    bool status = false;
-    auto res = reader->isSecureElementPresent(&status);
-    if (!res.isOk()) {
-        LOG(ERROR) << "isSecureElementPresent error: " << res.getMessage();
-        return false;
-    }
-    if (!status) {
-        LOG(ERROR) << "secure element not found";
-        return false;
-    }
-
-    if (session == nullptr || ((session->isClosed(&status).isOk() && status))) {
-        res = reader->openSession(&session);
-        if (!res.isOk()) {
-            LOG(ERROR) << "openSession error: " << res.getMessage();
-            return false;
-        }
-        if (session == nullptr) {
-            LOG(ERROR) << "Could not open session null";
-            return false;
-        }
-    }
-
-    if ((channel == nullptr || (channel->isClosed(&status).isOk() && status))) {
-        if (!mSBAccessController.isSelectAllowed()) {
-            LOG(ERROR) << "Select not allowed";
-            prepareErrorRepsponse(transmitResponse);
-            return false;
-        }
-
-        res = session->openLogicalChannel(mSelectableAid, 0x00, mSEListener, &channel);
-        if (!res.isOk()) {
-            LOG(ERROR) << "openLogicalChannel error: " << res.getMessage();
-            return false;
-        }
-        if (channel == nullptr) {
-            LOG(ERROR) << "Could not open channel null";
-            return false;
-        }
-
-        res = channel->getSelectResponse(&selectResponse);
-        if (!res.isOk()) {
-            LOG(ERROR) << "getSelectResponse error: " << res.getMessage();
-            return false;
-        }
-        if (selectResponse.size() < 2) {
-            LOG(ERROR) << "getSelectResponse size error";
-            return false;
-        }
-        mSBAccessController.parseResponse(selectResponse);
-    }
-
-    if (!mSBAccessController.isOperationAllowed(apdu[APDU_INS_OFFSET])) {
-        LOG(ERROR) << "command Ins:" << apdu[APDU_INS_OFFSET] << " not allowed";
-        prepareErrorRepsponse(transmitResponse);
-        return false;
-    }
-
-    res = channel->transmit(apdu, &transmitResponse);
-
-#ifdef INTERVAL_TIMER
-     int timeout = mSBAccessController.getSessionTimeout();
-     if(timeout == 0) {
-       closeSession(); //close immediately
-     } else {
-       LOGD_OMAPI("Set the timer with timeout " << timeout << " ms");
-       mTimer.set(mSBAccessController.getSessionTimeout(), this, omapiSessionTimerFunc);
-     }
-#else
-     closeSession();
-#endif
-
-    LOGD_OMAPI("STATUS OF TRNSMIT: " << res.getExceptionCode() << " Message: "
-              << res.getMessage());
-    if (!res.isOk()) {
-        LOG(ERROR) << "transmit error: " << res.getMessage();
-        return false;
-    }
-
-    return true;
-}
-
 void OmapiTransport::prepareErrorRepsponse(std::vector<uint8_t>& resp){
         resp.clear();
         resp.push_back(0xFF);
         resp.push_back(0xFF);
 }
 
-void OmapiTransport::closeSession() {
+bool OmapiTransport::closeSession() {
+    LOG(DEBUG) << "Closing session";
+    std::lock_guard<std::mutex> lock(mSessionLock);
+    closeSessionLocked();
+    return true;
+}
+
+void OmapiTransport::closeSessionLocked() {
     if (channel != nullptr) channel->close();
     if (session != nullptr) session->close();
+    channel = nullptr;
+    session = nullptr;
 }
-#endif
 
 }
 #endif // OMAPI_TRANSPORT
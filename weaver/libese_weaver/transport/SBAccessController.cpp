@@ -60,10 +60,11 @@ void SBAccessController::startTimer(bool isStart, IntervalTimer& t, int timeout,
     }
 }
 
-void SBAccessController::parseResponse(std::vector<uint8_t>& responseApdu) {
+bool SBAccessController::parseResponse(std::vector<uint8_t>& responseApdu) {
     // check if StrongBox Applet update is underway
-    if ((responseApdu[responseApdu.size() - UPGRADE_OFFSET_SW] & UPGRADE_MASK_BIT) ==
-        UPGRADE_MASK_VAL) {
+    if (responseApdu.size() >= UPGRADE_OFFSET_SW &&
+        (responseApdu[responseApdu.size() - UPGRADE_OFFSET_SW] & UPGRADE_MASK_BIT) ==
+            UPGRADE_MASK_VAL) {
         mIsUpdateInProgress = true;
         LOG(INFO) << "StrongBox Applet update is in progress";
         g_AccessAllowed = false;  // No access or Limited access
@@ -73,6 +74,10 @@ void SBAccessController::parseResponse(std::vector<uint8_t>& responseApdu) {
         g_AccessAllowed = true;  // Full access
         startTimer(false, mTimer, 0, nullptr);
     }
+    return mIsUpdateInProgress;
+}
+bool SBAccessController::isUpdateInProgress() {
+    return mIsUpdateInProgress;
 }
 int SBAccessController::getSessionTimeout() {
     if (mIsUpdateInProgress) {
@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "SessionTimeoutPolicy"
+#include <android-base/logging.h>
+
+#include <EseTransportUtils.h>
+#include <SBAccessController.h>
+#include <SessionTimeoutPolicy.h>
+
+namespace keymint::javacard {
+
+int SessionTimeoutPolicy::applyMinTimeout(int timeout, int fallbackTimeout) {
+    // applet upgrade & crypto operation timeouts are mandated, not raised
+    if (fallbackTimeout != REGULAR_SESSION_TIMEOUT) {
+        return timeout;
+    }
+    int minTimeout = mMinTimeout;
+    return (timeout < minTimeout) ? minTimeout : timeout;
+}
+
+void AdaptiveSessionTimeoutPolicy::onApdu() {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (!mIsIdle) {
+        return;
+    }
+    mIsIdle = false;
+    auto gap = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - mIdleSince)
+                       .count();
+    // gaps beyond the upper bound cost the same, keep them just above it
+    mGaps[mNextGap] = (gap > SESSION_MAX_TIMEOUT) ? (SESSION_MAX_TIMEOUT + 1) : gap;
+    mNextGap = (mNextGap + 1) % SESSION_POLICY_HISTORY;
+    if (mGapCount < SESSION_POLICY_HISTORY) mGapCount++;
+}
+
+int AdaptiveSessionTimeoutPolicy::getSessionTimeout(int fallbackTimeout) {
+    std::lock_guard<std::mutex> lock(mLock);
+    mIsIdle = true;
+    mIdleSince = std::chrono::steady_clock::now();
+    // applet upgrade & crypto operation timeouts are mandated, not learned
+    if (fallbackTimeout != REGULAR_SESSION_TIMEOUT || mGapCount < SESSION_POLICY_MIN_SAMPLES) {
+        return applyMinTimeout(fallbackTimeout, fallbackTimeout);
+    }
+    // optimal timeout is 0 or one of the recorded gaps, reopen on all longer gaps
+    long bestCost = (long)mGapCount * SESSION_REOPEN_COST;
+    int bestTimeout = 0;
+    for (int c = 0; c < mGapCount; c++) {
+        int candidate = mGaps[c];
+        if (candidate > SESSION_MAX_TIMEOUT) continue;
+        long cost = 0;
+        for (int i = 0; i < mGapCount; i++) {
+            if (mGaps[i] <= candidate) {
+                cost += mGaps[i] / SESSION_RESIDENCY_COST_DIV;
+            } else {
+                cost += candidate / SESSION_RESIDENCY_COST_DIV + SESSION_REOPEN_COST;
+            }
+        }
+        if (cost < bestCost || (cost == bestCost && candidate < bestTimeout)) {
+            bestCost = cost;
+            bestTimeout = candidate;
+        }
+    }
+    // margin for timer & scheduling jitter around the learned gap
+    bestTimeout += SESSION_TIMEOUT_MARGIN;
+    if (bestTimeout < SESSION_MIN_TIMEOUT) bestTimeout = SESSION_MIN_TIMEOUT;
+    bestTimeout = applyMinTimeout(bestTimeout, fallbackTimeout);
+    LOGD_OMAPI("Adaptive session timeout " << bestTimeout << " ms");
+    return bestTimeout;
+}
+}  // namespace keymint::javacard
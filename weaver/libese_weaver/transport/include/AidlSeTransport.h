@@ -0,0 +1,98 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include <aidl/android/hardware/secure_element/BnSecureElementCallback.h>
+#include <aidl/android/hardware/secure_element/ISecureElement.h>
+#include <android/binder_manager.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ITransport.h"
+#include <IntervalTimer.h>
+#include <SBAccessController.h>
+
+#define SE_CONNECT_TIMEOUT (2 * 1000)  // 2 secs, wait for HAL state after init
+
+namespace keymint::javacard {
+
+/**
+ * AidlSeTransport is derived from ITransport. This class talks to the AIDL secure element HAL
+ * directly, without the OMAPI system service in between. The logical channel to the applet is
+ * kept open across APDUs and closed by the session timer.
+ */
+class AidlSeTransport : public ITransport {
+
+public:
+    AidlSeTransport(const std::vector<uint8_t> &mAppletAID)
+        : ITransport(mAppletAID), mSelectableAid(mAppletAID) {
+    }
+
+    /**
+     * Gets the binder instance of the secure element HAL and registers for its state changes.
+     */
+    bool openConnection() override;
+    /**
+     * Transmists the data over the logical channel, opened on demand, and receives the data back.
+     */
+    bool sendData(std::span<const uint8_t> inData, std::span<uint8_t>& output) override;
+    /**
+     * Closes the logical channel, the connection to the HAL is kept.
+     */
+    bool closeChannel() override;
+    /**
+     * Closes the logical channel and drops the connection to the HAL.
+     */
+    bool closeConnection() override;
+    /**
+     * Returns the state of the connection status. Returns true if the connection is active, false if connection is
+     * broken.
+     */
+    bool isConnected() override;
+    /**
+     * Updates the connection state, reported by the HAL callback & death notification.
+     */
+    void onStateChange(bool connected);
+private:
+    SBAccessController mSBAccessController;
+    IntervalTimer mTimer;
+    std::vector<uint8_t> mSelectableAid;
+    std::shared_ptr<aidl::android::hardware::secure_element::ISecureElement> mSEClient = nullptr;
+    std::shared_ptr<aidl::android::hardware::secure_element::ISecureElementCallback> mCallback =
+            nullptr;
+    ::ndk::ScopedAIBinder_DeathRecipient mDeathRecipient;
+    /* SE state reported by the HAL, channels are lost once disconnected */
+    std::atomic<bool> mSEConnected = false;
+    /* Signals state changes to a connection waiting for the HAL callback */
+    std::mutex mStateLock;
+    std::condition_variable mStateCond;
+    /* Guards mSEClient & mOpenChannel against the session timer */
+    std::mutex mChannelLock;
+    int8_t mOpenChannel = -1;
+    constexpr static const char seHalServiceName[] =
+            "android.hardware.secure_element.ISecureElement/eSE1";
+
+    bool openChannelLocked(std::vector<uint8_t>& selectResponse);
+    void closeChannelLocked();
+    void prepareErrorRepsponse(std::vector<uint8_t>& resp);
+};
+}  // namespace keymint::javacard
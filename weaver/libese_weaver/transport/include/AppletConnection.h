@@ -41,6 +41,7 @@
 #include <android/hardware/secure_element/1.2/ISecureElement.h>
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
+#include <span>
 #include <vector>
 
 #include <SBAccessController.h>
@@ -81,7 +82,7 @@ public:
    * Sends the data to the secure element and also receives back the data.
    * This is a blocking call.
    */
-  bool transmit(std::vector<uint8_t>& CommandApdu, std::vector<uint8_t>& output);
+  bool transmit(std::span<const uint8_t> CommandApdu, std::span<uint8_t>& output);
 
   /**
    * Checks if a channel to the applet is open.
@@ -91,6 +92,14 @@ public:
    * Get session timeout value based on select response normal/update session
    */
   int getSessionTimeout();
+  /**
+   * Checks if last select response reported an applet update in progress
+   */
+  bool isAppletUpdateInProgress();
+  /**
+   * Checks if the secure element HAL service is connected
+   */
+  bool isServiceConnected();
 
  private:
   /**
@@ -16,6 +16,7 @@
  */
 #ifndef __ESE_TRANSPORT_CONFIG__
 #define __ESE_TRANSPORT_CONFIG__
+#include <span>
 #include <vector>
 
 namespace keymint::javacard {
@@ -40,5 +41,9 @@ static bool debug_omapi = true;
     LOG(INFO) <<"("<<__FUNCTION__ <<")"<<" "<<x;
 std::ostream& operator<<(std::ostream& os, const std::vector<uint8_t>& vec);
 
+// Copies response into caller buffer and narrows the view to its length,
+// returns false if caller buffer is too small
+bool copyResponse(const uint8_t* data, size_t len, std::span<uint8_t>& output);
+
 } // namespace keymint::javacard
 #endif /* __ESE_TRANSPORT_CONFIG__ */
@@ -62,7 +62,7 @@ public:
     /**
      * Transmists the data over the opened basic channel and receives the data back.
      */
-    bool sendData(const vector<uint8_t>& inData, vector<uint8_t>& output) override;
+    bool sendData(std::span<const uint8_t> inData, std::span<uint8_t>& output) override;
     /**
      * Closes the connection.
      */
@@ -35,12 +35,26 @@
  *********************************************************************************/
 #pragma once
 #include <memory>
+#include <span>
 #include <vector>
 
+#include "SessionTimeoutPolicy.h"
+
 namespace keymint::javacard {
 using std::shared_ptr;
 using std::vector;
 
+/**
+ * Events reported by the transport to the owner of the connection.
+ */
+enum class TransportEvent {
+    SE_CONNECTED,            // connection to secure element service (re)established
+    APPLET_UPDATE_DETECTED,  // SELECT response reports applet update in progress
+    APPLET_SELECTED,         // logical channel opened, SELECT response updated
+};
+
+typedef void (*TRANSPORT_EVENT_CB)(void* ctx, TransportEvent event);
+
 /**
  * ITransport is an interface with a set of virtual methods that allow communication between the
  * HAL and the applet on the secure element.
@@ -57,10 +71,22 @@ class ITransport {
     virtual bool openConnection() = 0;
     /**
      * Send data over communication channel and receives data back from the remote end.
+     * The response is written into the caller owned output buffer, and output is narrowed
+     * to the response length.
      */
-    virtual bool sendData(const vector<uint8_t>& inData, vector<uint8_t>& output) = 0;
+    virtual bool sendData(std::span<const uint8_t> inData, std::span<uint8_t>& output) = 0;
     /**
-     * Closes the connection.
+     * Closes the logical channel to the applet, the session to the secure element is kept
+     * for the next channel. Defaults to a full disconnect.
+     */
+    virtual bool closeChannel() { return closeConnection(); }
+    /**
+     * Closes the logical channel and the session to the secure element, the connection to
+     * the secure element service is kept. Defaults to closing the channel.
+     */
+    virtual bool closeSession() { return closeChannel(); }
+    /**
+     * Closes the connection, full disconnect from the secure element service.
      */
     virtual bool closeConnection() = 0;
     /**
@@ -68,5 +94,61 @@ class ITransport {
      * if connection is broken.
      */
     virtual bool isConnected() = 0;
+
+    /**
+     * Registers the callback to be notified of transport events. The callback is invoked from
+     * the thread performing the transport operation.
+     */
+    void setEventCallback(void* ctx, TRANSPORT_EVENT_CB cb) {
+        mEventCtx = ctx;
+        mEventCb = cb;
+    }
+
+    /**
+     * Replaces the policy deciding the idle timeout of the logical channel. Transports keep the
+     * constant timeouts of SBAccessController unless a client opts into another policy.
+     */
+    void setSessionTimeoutPolicy(shared_ptr<SessionTimeoutPolicy> policy) {
+        if (policy == nullptr) return;
+        policy->setMinTimeout(mMinSessionTimeout);
+        mSessionTimeoutPolicy = policy;
+    }
+
+    /**
+     * Sets the lower bound of the regular idle timeout of the logical channel, for a client
+     * which keeps the channel open for a hold period of its own and closes it itself.
+     */
+    void setMinSessionTimeout(int minTimeout) {
+        mMinSessionTimeout = minTimeout;
+        mSessionTimeoutPolicy->setMinTimeout(minTimeout);
+    }
+
+    /**
+     * Provides the SELECT response of the last opened logical channel. Returns false if no
+     * channel was opened yet.
+     */
+    bool getSelectResponse(std::vector<uint8_t>& resp) {
+        resp = mSelectResponse;
+        return !resp.empty();
+    }
+
+  protected:
+    void notifyEvent(TransportEvent event) {
+        if (mEventCb != nullptr) mEventCb(mEventCtx, event);
+    }
+
+    void onAppletSelected(const std::vector<uint8_t>& selectResponse) {
+        mSelectResponse = selectResponse;
+        notifyEvent(TransportEvent::APPLET_SELECTED);
+    }
+
+    shared_ptr<SessionTimeoutPolicy> mSessionTimeoutPolicy =
+            std::make_shared<FixedSessionTimeoutPolicy>();
+
+  private:
+    std::vector<uint8_t> mSelectResponse;
+    int mMinSessionTimeout = 0;
+    void* mEventCtx = nullptr;
+    TRANSPORT_EVENT_CB mEventCb = nullptr;
 };
 }  // namespace keymint::javacard
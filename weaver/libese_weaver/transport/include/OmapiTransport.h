@@ -45,12 +45,12 @@
 //#include <aidl/android/se/omapi/SecureElementErrorCode.h>
 #include <android/binder_manager.h>
 
-#include <map>
-
 #include "ITransport.h"
 #include <AppletConnection.h>
 #include <IntervalTimer.h>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include <SBAccessController.h>
@@ -78,9 +78,17 @@ public:
     /**
      * Transmists the data over the opened basic channel and receives the data back.
      */
-    bool sendData(const vector<uint8_t>& inData, vector<uint8_t>& output) override;
+    bool sendData(std::span<const uint8_t> inData, std::span<uint8_t>& output) override;
+    /**
+     * Closes the logical channel, the session is kept for the next channel.
+     */
+    bool closeChannel() override;
+    /**
+     * Closes the logical channel & session kept open across APDUs.
+     */
+    bool closeSession() override;
     /**
-     * Closes the connection.
+     * Closes all sessions on the eSE reader and drops the cached reader.
      */
     bool closeConnection() override;
     /**
@@ -88,7 +96,10 @@ public:
      * broken.
      */
     bool isConnected() override;
-    void closeSession();
+    /**
+     * Drops the cached eSE reader, next command rediscovers it.
+     */
+    void invalidateReader();
 private:
     //AppletConnection mAppletConnection;
     SBAccessController mSBAccessController;
@@ -98,8 +109,16 @@ private:
     std::shared_ptr<aidl::android::se::omapi::ISecureElementReader> eSEReader = nullptr;
     std::shared_ptr<aidl::android::se::omapi::ISecureElementSession> session = nullptr;
     std::shared_ptr<aidl::android::se::omapi::ISecureElementChannel> channel = nullptr;
-    std::map<std::string, std::shared_ptr<aidl::android::se::omapi::ISecureElementReader>>
-            mVSReaders = {};
+    std::shared_ptr<aidl::android::se::omapi::ISecureElementListener> mSEListener = nullptr;
+    /* Guards session & channel against the session timer */
+    std::mutex mSessionLock;
+    /* Guards omapiSeService & eSEReader against the binder death notification */
+    std::mutex mReaderLock;
+    ::ndk::ScopedAIBinder_DeathRecipient mDeathRecipient;
+    /* OMAPI service binder linked to mDeathRecipient */
+    ::ndk::SpAIBinder mOmapiBinder;
+    /* SE presence, confirmed once per reader & cleared on death or failure */
+    std::atomic<bool> mSEPresent = false;
     std::string const ESE_READER_PREFIX = "eSE";
     constexpr static const char omapiServiceName[] =
             "android.se.omapi.ISecureElementService/default";
@@ -107,10 +126,9 @@ private:
     bool initialize();
     bool internalTransmitApdu(
             std::shared_ptr<aidl::android::se::omapi::ISecureElementReader> reader,
-            std::vector<uint8_t> apdu, std::vector<uint8_t>& transmitResponse);
-    bool internalProtectedTransmitApdu(
-            std::shared_ptr<aidl::android::se::omapi::ISecureElementReader> reader,
-            std::vector<uint8_t> apdu, std::vector<uint8_t>& transmitResponse);
+            const std::vector<uint8_t>& apdu, std::vector<uint8_t>& transmitResponse);
+    void closeSessionLocked();
+    void invalidateReaderLocked();
     void prepareErrorRepsponse(std::vector<uint8_t>& resp);
 };
 }  // namespace keymint::javacard
@@ -61,9 +61,16 @@ class SBAccessController {
     /**
      * Parses SELECT cmd response to record if Applet upgrade is in progress
      * Params : R-APDU to SELECT cmd
-     * Returns : void
+     * Returns : true if Applet upgrade is detected else false
      */
-    void parseResponse(std::vector<uint8_t>& responseApdu);
+    bool parseResponse(std::vector<uint8_t>& responseApdu);
+
+    /**
+     * Provides Applet upgrade state recorded from last SELECT cmd response
+     * Params : void
+     * Returns : true if Applet upgrade is in progress else false
+     */
+    bool isUpdateInProgress();
 
     /**
      * Determins if current INS is allowed
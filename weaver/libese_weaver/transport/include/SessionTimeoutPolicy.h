@@ -0,0 +1,103 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+#ifndef _SESSIONTIMEOUTPOLICY_H_
+#define _SESSIONTIMEOUTPOLICY_H_
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#define SESSION_POLICY_HISTORY (16)      // inter-arrival samples kept
+#define SESSION_POLICY_MIN_SAMPLES (4)   // samples required before adapting
+#define SESSION_REOPEN_COST (150)        // ms, open logical channel & SELECT
+#define SESSION_RESIDENCY_COST_DIV (20)  // ms of residency worth 1 ms of reopen
+#define SESSION_TIMEOUT_MARGIN (50)      // 50 msecs, added to the learned gap
+#define SESSION_MIN_TIMEOUT (100)        // 100 msecs, lower bound when adapting
+#define SESSION_MAX_TIMEOUT (20 * 1000)  // 20 secs, upper bound when adapting
+
+namespace keymint::javacard {
+/**
+ * Policy deciding how long an idle logical channel is kept open before it is closed.
+ */
+class SessionTimeoutPolicy {
+  public:
+    virtual ~SessionTimeoutPolicy() {}
+
+    /**
+     * Records arrival of a command APDU
+     * Params : void
+     * Returns : void
+     */
+    virtual void onApdu() = 0;
+
+    /**
+     * Provides idle timeout to be armed once the current command APDU completed
+     * Params : fallback timeout from SBAccessController::getSessionTimeout in ms
+     * Returns : Session timeout value in ms
+     */
+    virtual int getSessionTimeout(int fallbackTimeout) = 0;
+
+    /**
+     * Sets the lower bound of the regular idle timeout, so that the channel outlives the hold
+     * period of a client closing it on its own. Mandated timeouts are not raised
+     * Params : lower bound in ms, 0 for none
+     * Returns : void
+     */
+    void setMinTimeout(int minTimeout) { mMinTimeout = minTimeout; }
+
+  protected:
+    int applyMinTimeout(int timeout, int fallbackTimeout);
+
+  private:
+    std::atomic<int> mMinTimeout = 0;
+};
+
+/**
+ * Policy keeping the constant timeouts of SBAccessController.
+ */
+class FixedSessionTimeoutPolicy : public SessionTimeoutPolicy {
+  public:
+    void onApdu() override {}
+    int getSessionTimeout(int fallbackTimeout) override {
+        return applyMinTimeout(fallbackTimeout, fallbackTimeout);
+    }
+};
+
+/**
+ * Policy learning the idle timeout from the idle gaps between recent command APDUs.
+ * The timeout minimizes, over the recorded gaps, the cost of keeping the channel resident
+ * plus the cost of reopening it for gaps longer than the timeout. Applet upgrade & crypto
+ * operation timeouts, and the regular timeout until enough gaps are known, are kept as is.
+ * The learned timeout never goes below the lower bound set by the client.
+ */
+class AdaptiveSessionTimeoutPolicy : public SessionTimeoutPolicy {
+  public:
+    void onApdu() override;
+    int getSessionTimeout(int fallbackTimeout) override;
+
+  private:
+    std::mutex mLock;
+    int mGaps[SESSION_POLICY_HISTORY] = {};  // ring buffer of idle gaps in ms
+    int mGapCount = 0;
+    int mNextGap = 0;
+    bool mIsIdle = false;  // set from completion of an APDU until arrival of next one
+    std::chrono::steady_clock::time_point mIdleSince;
+};
+}  // namespace keymint::javacard
+#endif /* _SESSIONTIMEOUTPOLICY_H_ */
@@ -0,0 +1,180 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+/* Measures the lazy Weaver HAL: resident memory released while the service
+ * is not running and latency of the first request after an on demand start.
+ *
+ * Usage: weaver_lazy_bench [-n iterations] [-i idle_ms]
+ *   idle_ms - idle timeout of the service, ro.vendor.weaver.lazy_idle_ms
+ * Run as root so that /proc of the service process is readable.
+ */
+#include <android/hardware/weaver/1.0/IWeaver.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using android::sp;
+using android::hardware::weaver::V1_0::IWeaver;
+using android::hardware::weaver::V1_0::WeaverConfig;
+using android::hardware::weaver::V1_0::WeaverStatus;
+using android::hidl::base::V1_0::DebugInfo;
+
+/* Default iterations & idle timeout, the latter matches the service default */
+#define BENCH_ITERATIONS 5
+#define BENCH_IDLE_TIMEOUT (30 * 1000) // 30 secs
+/* Extra time granted to the service to exit after its idle timeout */
+#define BENCH_EXIT_MARGIN (10 * 1000) // 10 secs
+#define BENCH_POLL_INTERVAL 50        // ms
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/* Resident set size of pid in kB, -1 if not readable */
+static long readRssKb(int pid) {
+  std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmRSS:") == 0) {
+      return strtol(line.c_str() + 6, nullptr, 10);
+    }
+  }
+  return -1;
+}
+
+static bool isRunning(int pid) {
+  return access(("/proc/" + std::to_string(pid)).c_str(), F_OK) == 0;
+}
+
+/* Waits up to timeoutMs for pid to exit, returns time taken or -1 */
+static double waitForExit(int pid, int timeoutMs) {
+  Clock::time_point start = Clock::now();
+  while (isRunning(pid)) {
+    if (elapsedMs(start) > timeoutMs) {
+      return -1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(BENCH_POLL_INTERVAL));
+  }
+  return elapsedMs(start);
+}
+
+/* Pid of the process serving weaver */
+static int getServicePid(const sp<IWeaver> &weaver) {
+  int pid = -1;
+  weaver->getDebugInfo([&](const DebugInfo &info) { pid = info.pid; });
+  return pid;
+}
+
+/* Issues getConfig, returns its latency or -1 on failure */
+static double timedGetConfig(const sp<IWeaver> &weaver) {
+  WeaverStatus status = WeaverStatus::FAILED;
+  Clock::time_point start = Clock::now();
+  auto ret = weaver->getConfig(
+      [&](WeaverStatus s, const WeaverConfig & /*config*/) { status = s; });
+  if (!ret.isOk() || status != WeaverStatus::OK) {
+    return -1;
+  }
+  return elapsedMs(start);
+}
+
+int main(int argc, char **argv) {
+  int iterations = BENCH_ITERATIONS;
+  int idleMs = BENCH_IDLE_TIMEOUT;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:i:")) != -1) {
+    switch (opt) {
+    case 'n':
+      iterations = atoi(optarg);
+      break;
+    case 'i':
+      idleMs = atoi(optarg);
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-n iterations] [-i idle_ms]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  /* Start from a stopped service so that every iteration is a restart */
+  sp<IWeaver> weaver = IWeaver::getService();
+  if (weaver == nullptr) {
+    fprintf(stderr, "IWeaver service not available\n");
+    return EXIT_FAILURE;
+  }
+  int pid = getServicePid(weaver);
+  weaver.clear();
+  if (waitForExit(pid, idleMs + BENCH_EXIT_MARGIN) < 0) {
+    fprintf(stderr, "service (pid %d) did not exit, lazy mode not enabled or "
+            "other clients holding it?\n", pid);
+    return EXIT_FAILURE;
+  }
+
+  double sumFirst = 0, maxFirst = 0, sumWarm = 0;
+  long sumRss = 0;
+  int done = 0;
+  for (int i = 0; i < iterations; i++) {
+    /* getService starts the lazy service through init if it is not running */
+    Clock::time_point start = Clock::now();
+    weaver = IWeaver::getService();
+    if (weaver == nullptr) {
+      fprintf(stderr, "IWeaver service not available\n");
+      return EXIT_FAILURE;
+    }
+    double getServiceMs = elapsedMs(start);
+    double firstMs = timedGetConfig(weaver);
+    double firstTotalMs = elapsedMs(start);
+    double warmMs = timedGetConfig(weaver);
+    if (firstMs < 0 || warmMs < 0) {
+      fprintf(stderr, "getConfig failed\n");
+      return EXIT_FAILURE;
+    }
+    pid = getServicePid(weaver);
+    long rssKb = readRssKb(pid);
+
+    /* Drop our reference, the service exits after its idle timeout */
+    weaver.clear();
+    double exitMs = waitForExit(pid, idleMs + BENCH_EXIT_MARGIN);
+    printf("#%d pid %d: start+getService %.1f ms, first getConfig %.1f ms, "
+           "total %.1f ms, warm getConfig %.1f ms, RSS %ld kB, exit after "
+           "%.0f ms\n",
+           i, pid, getServiceMs, firstMs, firstTotalMs, warmMs, rssKb, exitMs);
+    if (exitMs < 0) {
+      fprintf(stderr, "service (pid %d) did not exit\n", pid);
+      return EXIT_FAILURE;
+    }
+    sumFirst += firstTotalMs;
+    maxFirst = std::max(maxFirst, firstTotalMs);
+    sumWarm += warmMs;
+    sumRss += rssKb;
+    done++;
+  }
+  if (done == 0) {
+    return EXIT_FAILURE;
+  }
+  printf("RSS released while idle: %ld kB (avg)\n", sumRss / done);
+  printf("First call after restart: %.1f ms avg, %.1f ms max\n",
+         sumFirst / done, maxFirst);
+  printf("Call on running service: %.1f ms avg\n", sumWarm / done);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 NXP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+/* Compares the per-APDU cost of the secure element transports, OMAPI,
+ * HIDL secure_element HAL & AIDL secure_element HAL, sending the weaver
+ * getSlot command. Each transport is measured with its channel kept open
+ * (steady state) and with the channel closed after every APDU (cold).
+ *
+ * Usage: weaver_transport_bench [-n apdus] [-t omapi|hidl|aidl]
+ * Point the HALs at a mock eSE, e.g. the AOSP default secure_element HAL,
+ * to measure the transport hops rather than the applet.
+ */
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include <AidlSeTransport.h>
+#include <HalToHalTransport.h>
+#include <OmapiTransport.h>
+#include <weaver_applet_profile.h>
+
+using keymint::javacard::AidlSeTransport;
+using keymint::javacard::HalToHalTransport;
+using keymint::javacard::ITransport;
+using keymint::javacard::OmapiTransport;
+
+/* Default number of APDUs sent per transport & mode */
+#define BENCH_APDUS 200
+/* Capacity of the response buffer, short APDU encoding */
+#define BENCH_RESP_SIZE (256 + 2)
+
+typedef std::chrono::steady_clock Clock;
+
+/* Sends apdus getSlot commands, fills per APDU latency in us */
+static bool runApdus(ITransport &transport, int apdus, bool cold,
+                     std::vector<double> &latencies) {
+  const std::vector<uint8_t> cmd = {
+      WeaverActiveProfile::CLA, WeaverActiveProfile::INS_GET_SLOT,
+      WeaverActiveProfile::P1, WeaverActiveProfile::P2, sizeof(uint32_t)};
+  uint8_t resp[BENCH_RESP_SIZE];
+  for (int i = 0; i < apdus; i++) {
+    std::span<uint8_t> output(resp, sizeof(resp));
+    Clock::time_point start = Clock::now();
+    bool status = transport.sendData(cmd, output);
+    if (cold) {
+      transport.closeChannel();
+    }
+    latencies.push_back(
+        std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    if (!status) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void report(const char *name, const char *mode,
+                   std::vector<double> &latencies) {
+  if (latencies.empty()) {
+    return;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  double sum = 0;
+  for (double l : latencies) {
+    sum += l;
+  }
+  size_t n = latencies.size();
+  printf("%-6s %-6s %5zu APDUs: avg %8.1f us, p50 %8.1f us, p99 %8.1f us\n",
+         name, mode, n, sum / n, latencies[n / 2],
+         latencies[std::min(n - 1, n * 99 / 100)]);
+}
+
+static void bench(const char *name, ITransport &transport, int apdus) {
+  if (!transport.openConnection()) {
+    printf("%-6s not available\n", name);
+    return;
+  }
+  for (bool cold : {false, true}) {
+    std::vector<double> latencies;
+    /* first APDU opens the channel, keep it out of the steady state */
+    std::vector<double> warmUp;
+    runApdus(transport, 1, false, warmUp);
+    if (!runApdus(transport, apdus, cold, latencies)) {
+      printf("%-6s %-6s failed after %zu APDUs\n", name, cold ? "cold" : "steady",
+             latencies.size());
+    }
+    report(name, cold ? "cold" : "steady", latencies);
+  }
+  transport.closeConnection();
+}
+
+int main(int argc, char **argv) {
+  int apdus = BENCH_APDUS;
+  const char *only = nullptr;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:t:")) != -1) {
+    switch (opt) {
+    case 'n':
+      apdus = atoi(optarg);
+      break;
+    case 't':
+      only = optarg;
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-n apdus] [-t omapi|hidl|aidl]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  std::vector<uint8_t> aid(WeaverActiveProfile::AID.begin(),
+                           WeaverActiveProfile::AID.end());
+  if (only == nullptr || strcmp(only, "omapi") == 0) {
+    OmapiTransport omapi(aid);
+    bench("omapi", omapi, apdus);
+  }
+  if (only == nullptr || strcmp(only, "hidl") == 0) {
+    HalToHalTransport hidl(aid);
+    bench("hidl", hidl, apdus);
+  }
+  if (only == nullptr || strcmp(only, "aidl") == 0) {
+    AidlSeTransport aidl(aid);
+    bench("aidl", aidl, apdus);
+  }
+  return EXIT_SUCCESS;
+}